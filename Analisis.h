@@ -2,6 +2,12 @@
 #define ANALISIS_H
 
 #include "Dato.h"
+#include "Columna.h"
+#include "LectorCSV.h"
+#include "Filtro.h"
+#include "Estadisticas.h"
+#include "Snapshot.h"
+#include "Planificador.h"
 #include <fstream>
 #include <vector>
 #include <sstream>
@@ -10,25 +16,205 @@
 #include <map>
 #include <cmath>
 #include <set>
-#include <regex>
+#include <unordered_set>
 #include <functional>
 #include <filesystem>
 #include <iomanip>
+#include <array>
+#include <string_view>
+#include <thread>
+#include <atomic>
+#include <chrono>
+#include <exception>
+#include <limits>
+#include <optional>
+#include <mutex>
 
 using namespace std;
 
+// Result of CSVAnalyzer::streamCSV: a summary of a file whose rows were never
+// kept in memory
+struct StreamReport
+{
+    string filename;
+    vector<string> columnNames;
+    vector<DataType> columnTypes;
+    size_t rows = 0;
+    string filter;      // expression counted during the pass ("" = none)
+    size_t matched = 0; // rows matching 'filter'
+    vector<StreamColumnStats> columns;
+};
+
 class CSVAnalyzer
 {
 private:
-    vector<Dato> data;
+    // Worker pool for loading, statistics, filters and exports; shared with the
+    // loaders of columns read on first use, so it outlives the table
+    shared_ptr<TaskScheduler> scheduler = make_shared<TaskScheduler>();
+    CancellationToken cancellation; // set by cancel(), reset by every load
+
+    ColumnTable data;
     vector<string> columnNames;
     vector<DataType> columnTypes;
     string filename;
+    size_t loadedBytes = 0; // end of the last record read from 'filename'
     char delimiter;
+    bool internStrings = true; // deduplicate repeated STRING values while loading
+    size_t sketchAccuracy = 200; // k of the per-column quantile sketches (0 = none)
+    size_t exactFrequencyLimit = 1000000; // STRING columns with more distinct values use sketches
+    string snapshotDirectory = "Snapshots"; // where loads are cached ("" = never)
+    std::uintmax_t snapshotMinBytes = 64 << 20; // smaller files are just parsed
+    vector<QuantileSketch> sketches; // one per column, filled for numeric columns
+    optional<vector<string>> projection; // columns loadCSV converts (nullopt = all)
+
+    // Whole-column statistics, computed on first use, updated from appended
+    // rows only and dropped on a new load, so reports do not rescan the table
+    vector<ColumnStats> columnStats;
+
+    // Files are split into byte ranges of at least this size, so small files
+    // still load as a single chunk
+    static constexpr size_t minChunkBytes = 1 << 20;
+
+    // Rows per task (and per partial hash table) when values are counted
+    static constexpr size_t frequencyGrainRows = 1 << 16;
+
+    // Rows per task when the statistics of one column are split in row ranges.
+    // Ranges depend on the row count only, so the merged results are the same
+    // whatever the number of threads.
+    static constexpr size_t statsRangeRows = 1 << 22;
+
+    // Byte range of a file a streaming pass converts per worker at a time; the
+    // memory a pass needs is about this times the thread count
+    static constexpr size_t streamChunkBytes = 16 << 20;
+
+    // Turns bytes done into percent updates for a progress callback, only when
+    // the percentage changes. 100% is left to the caller, once it has finished.
+    struct ProgressReporter
+    {
+        std::function<void(int)> callback;
+        int lastReported = -1;
+
+        void operator()(std::uintmax_t done, std::uintmax_t total)
+        {
+            if (!callback || total == 0)
+                return;
+            int percent = static_cast<int>((double)done * 100.0 / (double)total);
+            // Reserve 100% for final completion to avoid duplicate "finished" bar
+            if (percent > 99)
+                percent = 99;
+            if (percent != lastReported)
+            {
+                lastReported = percent;
+                try
+                {
+                    callback(percent);
+                }
+                catch (...)
+                {
+                }
+            }
+        }
+    };
+
+    // What a streaming pass keeps of one chunk once its rows are dropped
+    struct StreamChunkResult
+    {
+        size_t rows = 0;
+        size_t matched = 0;
+        vector<StreamColumnStats> columns;
+    };
+
+    // One byte range of the file, converted by one worker
+    struct LoadChunk
+    {
+        size_t begin = 0;
+        size_t end = 0;
+        ColumnTable table;
+        vector<QuantileSketch> sketches;
+        size_t strayQuotes = 0; // quotes inside unquoted fields, kept as text
+    };
+
+public:
+    // Which rows type inference looks at: the first 'headRows' records plus
+    // 'strata' evenly spaced windows of 'rowsPerStratum' records each.
+    // Files shorter than the head are inferred from every row.
+    struct InferenceSampling
+    {
+        size_t headRows = 10000;
+        size_t strata = 32;
+        size_t rowsPerStratum = 1000;
+    };
+
+private:
+    InferenceSampling sampling;
+
+    // Per-column type scores and distinct values seen in the inference sample.
+    // Values are kept as 64-bit hashes: a cell view may point into the
+    // tokenizer's scratch buffer (unescaped quotes), which does not outlive
+    // the record, and the count only has to reach distinctLimit.
+    struct TypeSample
+    {
+        vector<array<int, 4>> typeScores;
+        vector<unordered_set<uint64_t>> distinctValues;
+        vector<char> highCardinality;
+        size_t distinctLimit = 0;
+        size_t rows = 0;
+    };
 
 public:
     CSVAnalyzer(char delim = ',') : delimiter(delim) {}
 
+    // Number of scheduler workers used by loading, statistics, filters and
+    // exports (0 = one per hardware thread)
+    void setWorkerThreads(unsigned threads) { scheduler->setWorkerCount(threads); }
+    unsigned getWorkerThreads() const { return scheduler->getWorkerCount(); }
+
+    // Kept for compatibility: same as setWorkerThreads
+    void setLoadThreads(unsigned threads) { setWorkerThreads(threads); }
+    unsigned getLoadThreads() const { return getWorkerThreads(); }
+
+    // Stop the load, refresh or streaming pass in progress, e.g. from its
+    // progress callback or another thread: chunks not started are skipped and
+    // the call returns false (0 rows for appendNewRows)
+    void cancel() { cancellation.cancel(); }
+
+    // Share the bytes of repeated STRING values (e.g. city names). Columns that
+    // turn out to be mostly unique stop interning on their own.
+    void setStringInterning(bool enabled) { internStrings = enabled; }
+    bool getStringInterning() const { return internStrings; }
+
+    // Accuracy (KLL k) of the quantile sketches built for every numeric column
+    // while loading; 0 skips them. Takes effect on the next load.
+    void setSketchAccuracy(size_t k) { sketchAccuracy = k; }
+    size_t getSketchAccuracy() const { return sketchAccuracy; }
+
+    // Text columns estimated to have more distinct values than this get their
+    // frequency tables from the heavy-hitter sketch kept with the column
+    // statistics (fixed memory, approximate counts with bounds) instead of an
+    // exact count, whose hash tables grow with the distinct values
+    void setExactFrequencyLimit(size_t distinctValues) { exactFrequencyLimit = distinctValues; }
+    size_t getExactFrequencyLimit() const { return exactFrequencyLimit; }
+
+    // Files of at least 'minBytes' are cached as binary snapshots in 'directory'
+    // after loading, and later loads of the same unchanged file (path, size and
+    // modification time) reopen the snapshot instead. "" turns caching off.
+    void setSnapshotCache(const string &directory, std::uintmax_t minBytes = 64 << 20)
+    {
+        snapshotDirectory = directory;
+        snapshotMinBytes = minBytes;
+    }
+
+    // Projection pushdown: the next loads convert only these columns, and the
+    // others are read from the file the first time something uses them. An
+    // empty list converts none up front, so the first query decides what is
+    // read. Unknown names are ignored. Loads with a projection are not cached
+    // as snapshots (an existing snapshot is still used).
+    void setColumnProjection(const vector<string> &columns) { projection = columns; }
+    void clearColumnProjection() { projection.reset(); }
+
+    void setInferenceSampling(const InferenceSampling &options) { sampling = options; }
+    const InferenceSampling &getInferenceSampling() const { return sampling; }
+
     // Method to load CSV file and automatically detect data types
     // Overload without progress callback kept for compatibility
     bool loadCSV(const string &filepath)
@@ -37,111 +223,467 @@ public:
     }
 
     // New: loadCSV with an optional progress callback (progress in percent 0..100)
+    // The file is memory-mapped and tokenized into string_views that point into
+    // the mapping; cells are converted straight from those views.
     bool loadCSV(const string &filepath, std::function<void(int)> progressCallback)
     {
         filename = filepath;
-        std::ifstream file(filepath);
+        cancellation.reset();
 
-        if (!file.is_open())
+        // An up-to-date snapshot of this file skips the parse entirely
+        SnapshotKey key;
+        bool cacheable = !snapshotDirectory.empty() && SnapshotKey::of(filepath, delimiter, key) &&
+                         key.size >= snapshotMinBytes;
+        if (cacheable && restoreSnapshot(snapshotPathFor(snapshotDirectory, key), &key))
+        {
+            filename = filepath;
+            if (progressCallback)
+                progressCallback(100);
+            std::cout << "Successfully loaded " << data.size() << " rows with "
+                      << columnNames.size() << " columns from " << filepath
+                      << " (snapshot)" << std::endl;
+            return true;
+        }
+
+        // Shared with the loader of the columns a projection leaves out
+        auto file = make_shared<MappedFile>();
+
+        if (!file->open(filepath))
         {
             std::cerr << "Error: Cannot open file " << filepath << std::endl;
             return false;
         }
 
         data.clear();
+        sketches.clear();
+        invalidateColumnStats();
+        loadedBytes = 0;
         columnNames.clear();
         columnTypes.clear();
 
-        string line;
-        bool isFirstLine = true;
-        vector<vector<string>> rawData;
+        string_view text = file->view();
 
-        // Attempt to get total file size for progress estimation
-        std::uintmax_t totalBytes = 0;
-        try
+        // The header is read up front; the rest of the file is split in chunks
+        vector<string_view> cells;
+        CSVTokenizer header(text, delimiter);
+        header.next(cells);
+        columnNames.assign(cells.begin(), cells.end());
+        size_t bodyStart = header.position();
+
+        // Types are inferred from a sample, so the file is only read once in full
+        columnTypes = detectDataTypes(text, bodyStart, columnNames.size());
+
+        // Columns converted now; the rest are left to a loader (see below)
+        vector<char> wanted(columnNames.size(), 1);
+        if (projection)
         {
-            totalBytes = std::filesystem::file_size(filepath);
+            wanted.assign(columnNames.size(), 0);
+            for (const auto &name : *projection)
+            {
+                auto it = find(columnNames.begin(), columnNames.end(), name);
+                if (it != columnNames.end())
+                    wanted[it - columnNames.begin()] = 1;
+                else
+                    std::cerr << "Warning: column '" << name << "' not found in " << filepath << std::endl;
+            }
         }
-        catch (...)
+        bool projected = find(wanted.begin(), wanted.end(), 0) != wanted.end();
+
+        vector<LoadChunk> chunks = splitIntoChunks(text, bodyStart);
+
+        std::uintmax_t totalBytes = file->size();
+        std::atomic<std::uintmax_t> bytesConverted{bodyStart};
+        ProgressReporter report{progressCallback};
+
+        // Convert every chunk into its own table, then stitch them in order
+        shared_ptr<const Schema> schema = Schema::create(columnNames, columnTypes);
+        bool finished = runChunks(chunks, [&](LoadChunk &chunk)
+                                  { convertChunk(text, chunk, schema, bytesConverted, projected ? &wanted : nullptr); },
+                                  [&]
+                                  { report(bytesConverted.load(), totalBytes); });
+        if (!finished)
         {
-            totalBytes = 0;
+            columnNames.clear();
+            columnTypes.clear();
+            std::cerr << "Load of " << filepath << " cancelled" << std::endl;
+            return false;
         }
 
-        std::uintmax_t bytesRead = 0;
-        int lastReported = -1;
+        data.setSchema(schema);
+        appendChunks(chunks);
+        loadedBytes = text.size();
+
+        // Columns outside the projection are converted from the same records
+        // the first time they are read
+        if (projected && !data.empty())
+        {
+            vector<char> pending(wanted.size());
+            for (size_t i = 0; i < wanted.size(); ++i)
+                pending[i] = !wanted[i];
+            data.setColumnLoader(std::move(pending), deferredColumnLoader(file, chunks, schema));
+        }
+
+        // Ensure the progress UI reaches 100% before printing completion message
+        if (progressCallback)
+            progressCallback(100);
+
+        // The header is kept, so appendNewRows can still read rows added later
+        if (data.empty())
+        {
+            std::cerr << "Error: No data rows found in CSV" << std::endl;
+            return false;
+        }
+
+        std::cout << "Successfully loaded " << data.size() << " rows with "
+                  << columnNames.size() << " columns from " << filepath << std::endl;
+
+        reportParseFailures(vector<size_t>(columnNames.size(), 0));
+
+        // A snapshot needs every column, which would undo the projection
+        if (cacheable && !projected)
+            saveSnapshot(snapshotPathFor(snapshotDirectory, key));
+
+        return true;
+    }
+
+    // Save the loaded table, its column statistics (all computed first) and
+    // quantile sketches as a binary snapshot (see Snapshot.h)
+    bool saveSnapshot(const string &snapshotFile)
+    {
+        SnapshotKey key;
+        if (data.empty() || !SnapshotKey::of(filename, delimiter, key))
+        {
+            std::cerr << "Error: No loaded file to snapshot" << std::endl;
+            return false;
+        }
+        // Rows appended by follow mode are not in the file as the key describes it
+        key.size = loadedBytes;
+
+        for (size_t i = 0; i < columnNames.size(); ++i)
+            getColumnStats(i);
+
+        string error;
+        if (!writeSnapshot(snapshotFile, key, data, columnStats, sketches, error))
+        {
+            std::cerr << "Error: " << error << std::endl;
+            return false;
+        }
+        std::cout << "Snapshot saved: " << snapshotFile << std::endl;
+        return true;
+    }
+
+    // Reopen a snapshot written by saveSnapshot, whatever the state of its
+    // source file; columns are read from it on first use
+    bool openSnapshot(const string &snapshotFile)
+    {
+        if (!restoreSnapshot(snapshotFile, nullptr))
+        {
+            std::cerr << "Error: " << snapshotFile << " is not a valid snapshot" << std::endl;
+            return false;
+        }
+        return true;
+    }
+
+    // Follow mode: read only the rows appended to the loaded file since the
+    // last load or refresh. Records are taken up to the last complete line, so
+    // a row still being written is picked up by the next call. Cached column
+    // statistics and quantile sketches are updated from the new rows alone.
+    // A file that only had its header when loaded gets its types from the
+    // first rows that arrive. Columns not read yet (a projected load or a
+    // snapshot) stay pending and get the new rows when they are first read.
+    // Returns the number of rows added.
+    size_t appendNewRows()
+    {
+        if (data.getColumnCount() == 0)
+            return 0;
+        cancellation.reset();
+
+        auto file = make_shared<MappedFile>();
+        if (!file->open(filename))
+        {
+            std::cerr << "Error: Cannot open file " << filename << std::endl;
+            return 0;
+        }
+
+        string_view text = file->view();
+        if (text.size() < loadedBytes)
+        {
+            std::cerr << "Warning: " << filename << " is shorter than when it was loaded;"
+                      << " load it again to start over" << std::endl;
+            return 0;
+        }
+
+        size_t end = completeRecordsEnd(text, loadedBytes, delimiter);
+        if (end == loadedBytes)
+            return 0;
+
+        if (data.empty())
+        {
+            columnTypes = detectDataTypes(text.substr(0, end), loadedBytes, columnNames.size());
+            data.setSchema(Schema::create(columnNames, columnTypes));
+            sketches.clear();
+            invalidateColumnStats();
+        }
+
+        vector<char> wanted(columnNames.size());
+        vector<size_t> failuresBefore(columnNames.size(), 0);
+        for (size_t i = 0; i < columnNames.size(); ++i)
+        {
+            wanted[i] = data.isColumnLoaded(i);
+            if (wanted[i])
+                failuresBefore[i] = data.getColumn(i).getParseFailureCount();
+        }
+        bool projected = find(wanted.begin(), wanted.end(), 0) != wanted.end();
+
+        // Same conversion as loadCSV, restricted to the new byte range
+        vector<LoadChunk> chunks = splitIntoChunks(text.substr(0, end), loadedBytes);
+        std::atomic<std::uintmax_t> bytesConverted{0};
+        shared_ptr<const Schema> schema = data.getSchema();
+        if (!runChunks(chunks, [&](LoadChunk &chunk)
+                       { convertChunk(text, chunk, schema, bytesConverted, projected ? &wanted : nullptr); },
+                       [] {}))
+            return 0;
+
+        size_t before = data.size();
+        if (projected)
+        {
+            auto tail = [loader = deferredColumnLoader(file, chunks, schema)](size_t index, Column &column)
+            {
+                Column rows;
+                loader(index, rows);
+                column.appendFrom(std::move(rows));
+            };
+            data.extendColumnLoader(tail);
+        }
+        appendChunks(chunks, projected);
+        loadedBytes = end;
+
+        // Statistics already computed take in the new rows now (those of
+        // pending columns catch up when the column is read)
+        for (size_t i = 0; i < columnStats.size(); ++i)
+        {
+            if (columnStats[i].rows > 0 && data.isColumnLoaded(i))
+                updateColumnStats(columnStats[i], data.getColumn(i));
+        }
 
-        // Read all data first, reporting progress if callback provided
-        while (std::getline(file, line))
+        reportParseFailures(failuresBefore);
+        return data.size() - before;
+    }
+
+    // Call appendNewRows every 'interval' until 'onRefresh', given the number
+    // of rows each poll added, returns false
+    void followCSV(std::chrono::milliseconds interval, const std::function<bool(size_t)> &onRefresh)
+    {
+        while (onRefresh(appendNewRows()))
+            std::this_thread::sleep_for(interval);
+    }
+
+    // Streaming mode for files too large to load: one pass over the file, each
+    // worker converting, summarizing and dropping one chunk of rows at a time
+    // (memory stays around streamChunkBytes per thread). Gives counts, numeric
+    // moments, approximate quantiles and histograms from the sketches, bounded
+    // frequency tables and, with 'filter' (a FilterExpression), the number of
+    // matching rows. A table loaded with loadCSV is left untouched.
+    bool streamCSV(const string &filepath, StreamReport &result, const string &filter = "",
+                   std::function<void(int)> progressCallback = nullptr)
+    {
+        cancellation.reset();
+        MappedFile file;
+        if (!file.open(filepath))
+        {
+            std::cerr << "Error: Cannot open file " << filepath << std::endl;
+            return false;
+        }
+        string_view text = file.view();
+
+        vector<string_view> cells;
+        CSVTokenizer header(text, delimiter);
+        header.next(cells);
+        size_t bodyStart = header.position();
+
+        result = StreamReport();
+        result.filename = filepath;
+        result.filter = filter;
+        result.columnNames.assign(cells.begin(), cells.end());
+        result.columnTypes = detectDataTypes(text, bodyStart, result.columnNames.size(), false);
+        shared_ptr<const Schema> schema = Schema::create(result.columnNames, result.columnTypes);
+
+        // Catch filter mistakes before reading the file, against an empty table
+        if (!filter.empty())
         {
-            vector<string> row = parseLine(line);
+            ColumnTable emptyTable;
+            emptyTable.setSchema(schema);
+            FilterExpression expression;
+            string error;
+            if (!FilterExpression::parse(emptyTable, filter, expression, error))
+            {
+                std::cerr << "Error: " << error << std::endl;
+                return false;
+            }
+        }
+
+        StreamColumnStats initial;
+        if (sketchAccuracy > 0)
+            initial.sketch = QuantileSketch(sketchAccuracy);
+        result.columns.assign(result.columnNames.size(), initial);
 
-            if (isFirstLine)
+        size_t threads = scheduler->getWorkerCount();
+        std::atomic<std::uintmax_t> bytesConverted{bodyStart};
+        ProgressReporter report{progressCallback};
+
+        // One window of 'threads' chunks at a time; its pages are released
+        // once it has been summarized
+        size_t position = bodyStart;
+        while (position < text.size())
+        {
+            size_t windowEnd = recordBoundaryAfter(text, position, position + threads * streamChunkBytes, delimiter);
+            vector<size_t> boundaries = splitRecordAligned(text.substr(0, windowEnd), position, threads, delimiter);
+            vector<LoadChunk> chunks(boundaries.size() - 1);
+            for (size_t i = 0; i + 1 < boundaries.size(); ++i)
             {
-                columnNames = row;
-                isFirstLine = false;
+                chunks[i].begin = boundaries[i];
+                chunks[i].end = boundaries[i + 1];
             }
-            else
+
+            vector<StreamChunkResult> partials(chunks.size());
+            bool finished = runChunks(chunks, [&](LoadChunk &chunk)
+                                      {
+                                          StreamChunkResult &partial = partials[&chunk - chunks.data()];
+                                          convertChunk(text, chunk, schema, bytesConverted);
+                                          summarizeStreamChunk(chunk, filter, partial);
+                                          chunk = LoadChunk(); },
+                                      [&]
+                                      { report(bytesConverted.load(), text.size()); });
+            if (!finished)
             {
-                if (row.size() == columnNames.size())
-                {
-                    rawData.push_back(row);
-                }
+                std::cerr << "Streaming pass over " << filepath << " cancelled" << std::endl;
+                return false;
             }
 
-            if (progressCallback && totalBytes > 0)
+            // Merged in file order, so the result does not depend on timing
+            for (const auto &partial : partials)
             {
-                // Use cumulative bytes of the lines we've processed to estimate progress.
-                // This is more consistent across platforms than relying on tellg() after getline.
-                bytesRead += static_cast<std::uintmax_t>(line.size()) + 1; // +1 for newline
-                int percent = static_cast<int>((double)bytesRead * 100.0 / (double)totalBytes);
-                // Reserve 100% for final completion to avoid duplicate "finished" bar
-                if (percent > 99)
-                    percent = 99;
-                if (percent != lastReported)
-                {
-                    lastReported = percent;
-                    try
-                    {
-                        progressCallback(percent);
-                    }
-                    catch (...)
-                    {
-                    }
-                }
+                result.rows += partial.rows;
+                result.matched += partial.matched;
+                for (size_t i = 0; i < partial.columns.size(); ++i)
+                    result.columns[i].merge(partial.columns[i]);
             }
+
+            file.discard(position, windowEnd - position);
+            position = windowEnd;
         }
-        file.close();
 
-        if (rawData.empty())
+        if (progressCallback)
+            progressCallback(100);
+
+        if (result.rows == 0)
         {
             std::cerr << "Error: No data rows found in CSV" << std::endl;
-            if (progressCallback)
-                progressCallback(100);
             return false;
         }
+        return true;
+    }
 
-        detectDataTypes(rawData);
+    // Basic, numeric and categorical statistics of a streaming pass
+    void printStreamReport(const StreamReport &result) const
+    {
+        std::cout << "\n===== STREAMING SUMMARY =====" << std::endl;
+        std::cout << "Dataset: " << result.filename << std::endl;
+        std::cout << "Rows: " << result.rows << " (summarized in one pass, not kept in memory)" << std::endl;
+        std::cout << "Columns: " << result.columnNames.size() << std::endl;
+        if (!result.filter.empty())
+        {
+            std::cout << "Filter: " << result.filter << std::endl;
+            std::cout << "Matching rows: " << result.matched << " (" << std::fixed << std::setprecision(2)
+                      << (double)result.matched / result.rows * 100.0 << "%)" << std::endl;
+        }
+        std::cout << std::endl;
 
-        std::uintmax_t avgRowBytes = 0;
-        if (rawData.size() > 0 && totalBytes > 0)
+        std::cout << std::setw(20) << "Column Name"
+                  << std::setw(15) << "Data Type"
+                  << std::setw(15) << "Non-null Count"
+                  << std::setw(18) << "Distinct (est.)" << std::endl;
+        std::cout << std::string(68, '-') << std::endl;
+        for (size_t i = 0; i < result.columnNames.size(); ++i)
         {
-            avgRowBytes = totalBytes / rawData.size();
-            if (avgRowBytes == 0)
-                avgRowBytes = 1;
+            std::cout << std::setw(20) << result.columnNames[i]
+                      << std::setw(15) << dataTypeToString(result.columnTypes[i])
+                      << std::setw(15) << result.columns[i].count
+                      << std::setw(18) << result.columns[i].distinctValues.estimate() << std::endl;
         }
 
-        std::uintmax_t totalWork = totalBytes + avgRowBytes * rawData.size();
+        std::cout << "\n===== NUMERIC STATISTICS =====" << std::endl;
+        for (size_t i = 0; i < result.columnNames.size(); ++i)
+        {
+            const StreamColumnStats &column = result.columns[i];
+            if (column.summary.empty())
+                continue;
+
+            std::cout << "Statistics for '" << result.columnNames[i] << "':" << std::endl;
+            std::cout << "  Count: " << column.summary.count << std::endl;
+            std::cout << "  Mean: " << std::fixed << std::setprecision(2) << column.summary.mean << std::endl;
+            std::cout << "  Std Dev: " << column.summary.stddev() << std::endl;
+            std::cout << "  Min: " << column.summary.min << std::endl;
+            std::cout << "  Max: " << column.summary.max << std::endl;
+            if (!column.sketch.empty())
+            {
+                vector<double> pct = column.sketch.percentiles({25, 50, 75, 90, 99});
+                std::cout << "  Q1 (approx.): " << pct[0] << std::endl;
+                std::cout << "  Median (approx.): " << pct[1] << std::endl;
+                std::cout << "  Q3 (approx.): " << pct[2] << std::endl;
+                std::cout << "  P90 (approx.): " << pct[3] << std::endl;
+                std::cout << "  P99 (approx.): " << pct[4] << std::endl;
+            }
+            std::cout << std::endl;
+        }
 
-        convertRawDataToDato(rawData, progressCallback, bytesRead, totalWork, avgRowBytes);
+        std::cout << "===== CATEGORICAL STATISTICS =====" << std::endl;
+        for (size_t i = 0; i < result.columnNames.size(); ++i)
+        {
+            const StreamColumnStats &column = result.columns[i];
+            if (result.columnTypes[i] != DataType::CATEGORY && result.columnTypes[i] != DataType::STRING)
+                continue;
+
+            FrequencyReport table;
+            table.distinct = column.distinctValues.estimate();
+            table.distinctError = HyperLogLog::relativeError();
+            table.unlistedBound = column.frequency.unlistedBound();
+            table.approximate = table.unlistedBound > 0; // exact until the sketch fills up
+            for (const auto &hitter : column.frequency.top(20))
+            {
+                table.top.emplace_back(hitter.value, hitter.count);
+                table.bounds.push_back(hitter.lower);
+            }
+            printFrequencyTable(result.columnNames[i], table, result.rows);
+            std::cout << std::endl;
+        }
+    }
 
-        // Ensure the progress UI reaches 100% before printing completion message
-        if (progressCallback)
-            progressCallback(100);
+    // Histogram of a numeric column of a streaming pass, from its sketch
+    void plotStreamHistogram(const StreamReport &result, const string &columnName, int bins = 10) const
+    {
+        auto it = find(result.columnNames.begin(), result.columnNames.end(), columnName);
+        if (it == result.columnNames.end())
+        {
+            cout << "Error: Columna '" << columnName << "' no encontrada.\n";
+            return;
+        }
 
-        std::cout << "Successfully loaded " << data.size() << " rows with "
-                  << columnNames.size() << " columns from " << filepath << std::endl;
+        const StreamColumnStats &column = result.columns[it - result.columnNames.begin()];
+        if (column.summary.empty() || column.sketch.empty())
+        {
+            cout << "Error: El histograma solo funciona con columnas numericas (Integer/Float).\n";
+            return;
+        }
+        if (column.summary.min == column.summary.max)
+        {
+            cout << "Todos los valores son iguales (" << column.summary.min << "). No se puede graficar.\n";
+            return;
+        }
 
-        return true;
+        drawHistogram(columnName, column.summary.min, column.summary.max,
+                      column.sketch.binCounts(column.summary.min, column.summary.max, bins));
+        cout << "(Conteos aproximados, calculados con el sketch de cuantiles)\n";
     }
 
     void printBasicStatistics()
@@ -165,6 +707,7 @@ public:
                   << std::setw(15) << "Non-null Count" << std::endl;
         std::cout << std::string(50, '-') << std::endl;
 
+        prepareColumnStats();
         for (size_t i = 0; i < columnNames.size(); ++i)
         {
             int nonNullCount = getNonNullCount(i);
@@ -176,7 +719,8 @@ public:
     }
 
     // Method to get detailed statistics for numeric columns
-    void printNumericStatistics()
+    // With a selection, only the selected rows are summarized
+    void printNumericStatistics(const RowSelection *selection = nullptr)
     {
         if (data.empty())
         {
@@ -185,14 +729,23 @@ public:
         }
 
         std::cout << "\n===== NUMERIC STATISTICS =====" << std::endl;
+        if (selection)
+            std::cout << "(" << selection->size() << " of " << data.size() << " rows selected)" << std::endl;
+
+        // Every column is computed (in parallel) before anything is printed
+        vector<size_t> numeric = columnsOfType({DataType::INTEGER, DataType::FLOAT});
+        vector<NumericColumnReport> reports(numeric.size());
+        if (selection)
+            loadColumns(numeric);
+        else
+            prepareColumnStats(numeric);
+        runTasks(numeric.size(), [&](size_t task)
+                 { reports[task] = numericColumnReport(numeric[task], selection); });
 
-        for (size_t i = 0; i < columnNames.size(); ++i)
+        for (size_t task = 0; task < numeric.size(); ++task)
         {
-            if (columnTypes[i] == DataType::INTEGER || columnTypes[i] == DataType::FLOAT)
-            {
-                printColumnStatistics(i);
-                std::cout << std::endl;
-            }
+            printNumericColumnReport(numeric[task], reports[task]);
+            std::cout << std::endl;
         }
     }
 
@@ -206,20 +759,22 @@ public:
 
         std::cout << "\n===== CATEGORICAL STATISTICS =====" << std::endl;
 
-        bool foundCategory = false;
-        for (size_t i = 0; i < columnNames.size(); ++i)
+        // We check for BOTH explicitly declared Categories AND Strings
+        // (Since "Name" might be detected as String but we still want frequency stats)
+        vector<size_t> categorical = columnsOfType({DataType::CATEGORY, DataType::STRING});
+        vector<FrequencyReport> tables(categorical.size());
+        loadColumns(categorical);
+        prepareColumnStats(categorical);
+        runTasks(categorical.size(), [&](size_t task)
+                 { tables[task] = getFrequencies(categorical[task], 20); });
+
+        for (size_t task = 0; task < categorical.size(); ++task)
         {
-            // We check for BOTH explicitly declared Categories AND Strings
-            // (Since "Name" might be detected as String but we still want frequency stats)
-            if (columnTypes[i] == DataType::CATEGORY || columnTypes[i] == DataType::STRING)
-            {
-                printFrequencyAnalysis(i);
-                std::cout << std::endl;
-                foundCategory = true;
-            }
+            printFrequencyTable(categorical[task], tables[task]);
+            std::cout << std::endl;
         }
 
-        if (!foundCategory)
+        if (categorical.empty())
         {
             std::cout << "No categorical columns found." << std::endl;
         }
@@ -229,16 +784,15 @@ public:
     // NUEVAS FUNCIONES PARA EL PROYECTO FINAL
     // =========================================================
 
-    void plotHistogram(const string &columnName, int bins = 10)
+    void plotHistogram(const string &columnName, int bins = 10, const RowSelection *selection = nullptr)
     {
         // 1. Validar existencia de columna
-        auto it = find(columnNames.begin(), columnNames.end(), columnName);
-        if (it == columnNames.end())
+        size_t colIdx = findColumn(columnName);
+        if (colIdx == Schema::npos)
         {
             cout << "Error: Columna '" << columnName << "' no encontrada.\n";
             return;
         }
-        size_t colIdx = distance(columnNames.begin(), it);
 
         // 2. Validar que sea numérico (no podemos hacer histograma de texto)
         if (columnTypes[colIdx] != DataType::INTEGER && columnTypes[colIdx] != DataType::FLOAT)
@@ -247,26 +801,20 @@ public:
             return;
         }
 
-        // 3. Recolectar datos
-        vector<double> values;
-        for (const auto &row : data)
-        {
-            if (row.isNumericColumn(colIdx))
-            {
-                values.push_back(row.getNumericValue(colIdx));
-            }
-        }
+        // 3. Min y Max en una pasada vectorizada (sin copiar los valores)
+        const Column &column = data.getColumn(colIdx);
+        NumericSummary summary = selection ? summarizeNumericColumn(colIdx, selection)
+                                           : getColumnStats(colIdx).summary;
 
-        if (values.empty())
+        if (summary.empty())
         {
             cout << "No hay datos validos para graficar.\n";
             return;
         }
 
         // 4. Calcular Min, Max y el paso (step)
-        auto [minIt, maxIt] = minmax_element(values.begin(), values.end());
-        double minVal = *minIt;
-        double maxVal = *maxIt;
+        double minVal = summary.min;
+        double maxVal = summary.max;
 
         if (minVal == maxVal)
         {
@@ -276,41 +824,23 @@ public:
 
         double range = maxVal - minVal;
         double step = range / bins;
-        vector<int> binCounts(bins, 0);
+        vector<size_t> binCounts(bins, 0);
 
-        // 5. Llenar las "cubetas" (bins)
-        for (double v : values)
-        {
+        // 5. Llenar las "cubetas" (bins), leyendo la columna en su lugar
+        forEachNumericValue(column, selection, [&](double v)
+                            {
             int bucket = min((int)((v - minVal) / step), bins - 1);
             if (bucket >= 0 && bucket < bins)
             {
                 binCounts[bucket]++;
-            }
-        }
+            } });
 
         // 6. Dibujar en consola
-        cout << "\n===== HISTOGRAMA: " << columnName << " =====" << endl;
-        cout << "Rango: [" << minVal << " a " << maxVal << "]\n"
-             << endl;
-
-        int maxCount = *max_element(binCounts.begin(), binCounts.end());
-
-        for (int i = 0; i < bins; ++i)
-        {
-            double binStart = minVal + (i * step);
-            double binEnd = minVal + ((i + 1) * step);
-
-            // Etiqueta del rango
-            cout << fixed << setprecision(1) << setw(8) << binStart << " - " << setw(8) << binEnd << " | ";
-
-            // Barra ASCII (normalizada a 40 caracteres de largo)
-            int barLength = (maxCount > 0) ? (binCounts[i] * 40 / maxCount) : 0;
-            cout << string(barLength, '*') << " (" << binCounts[i] << ")\n";
-        }
-        cout << string(60, '-') << endl;
+        drawHistogram(columnName, minVal, maxVal, binCounts);
     }
 
-    void exportReportTXT(const string &filename)
+    // With a selection, the statistics and the preview cover only those rows
+    void exportReportTXT(const string &filename, const RowSelection *selection = nullptr)
     {
         ofstream file(filename);
         if (!file.is_open())
@@ -325,6 +855,8 @@ public:
         file << "===============================================\n";
         file << "Archivo Analizado: " << this->filename << "\n";
         file << "Total Registros:   " << data.size() << "\n";
+        if (selection)
+            file << "Registros Filtro:  " << selection->size() << "\n";
         file << "Total Columnas:    " << columnNames.size() << "\n";
         file << "===============================================\n\n";
 
@@ -340,30 +872,30 @@ public:
         file << "\n";
 
         // Sección 2: Estadísticas Rápidas (Solo numéricas)
+        // Todas las columnas se calculan en paralelo antes de escribir
         file << "--- RESUMEN ESTADISTICO (Numerico) ---\n";
-        for (size_t i = 0; i < columnNames.size(); ++i)
+        vector<size_t> numeric = columnsOfType({DataType::INTEGER, DataType::FLOAT});
+        vector<NumericSummary> summaries(numeric.size());
+        if (selection)
+            loadColumns(numeric);
+        else
+            prepareColumnStats(numeric);
+        runTasks(numeric.size(), [&](size_t task)
+                 {
+                     // Sin filtro se reutilizan las estadisticas ya calculadas
+                     summaries[task] = selection ? summarizeNumericColumn(numeric[task], selection)
+                                                 : columnStats[numeric[task]].summary; });
+
+        for (size_t task = 0; task < numeric.size(); ++task)
         {
-            if (columnTypes[i] == DataType::INTEGER || columnTypes[i] == DataType::FLOAT)
+            const NumericSummary &summary = summaries[task];
+            if (!summary.empty())
             {
-
-                // Recalcular rápido para el reporte
-                vector<double> vals;
-                for (const auto &row : data)
-                    if (row.isNumericColumn(i))
-                        vals.push_back(row.getNumericValue(i));
-
-                if (!vals.empty())
-                {
-                    double sum = accumulate(vals.begin(), vals.end(), 0.0);
-                    double mean = sum / vals.size();
-                    auto [minIt, maxIt] = minmax_element(vals.begin(), vals.end());
-
-                    file << "* Columna: " << columnNames[i] << "\n";
-                    file << "  - Promedio: " << mean << "\n";
-                    file << "  - Minimo:   " << *minIt << "\n";
-                    file << "  - Maximo:   " << *maxIt << "\n";
-                    file << "--------------------------------\n";
-                }
+                file << "* Columna: " << columnNames[numeric[task]] << "\n";
+                file << "  - Promedio: " << summary.mean << "\n";
+                file << "  - Minimo:   " << summary.min << "\n";
+                file << "  - Maximo:   " << summary.max << "\n";
+                file << "--------------------------------\n";
             }
         }
 
@@ -377,12 +909,13 @@ public:
         file << "\n";
 
         // Rows
-        int limit = min((int)data.size(), 10);
-        for (int i = 0; i < limit; ++i)
+        size_t limit = min(selection ? selection->size() : data.size(), (size_t)10);
+        for (size_t i = 0; i < limit; ++i)
         {
+            size_t row = selection ? (*selection)[i] : i;
             for (size_t c = 0; c < columnNames.size(); ++c)
             {
-                file << data[i].getValueAsString(c) << (c < columnNames.size() - 1 ? "," : "");
+                file << data[row].getValueAsString(c) << (c < columnNames.size() - 1 ? "," : "");
             }
             file << "\n";
         }
@@ -422,466 +955,998 @@ public:
         }
     }
 
+    // Print the first 'numRows' rows of a selection, read from the table in place
+    void printSelection(const RowSelection &selection, int numRows = 10)
+    {
+        int shown = std::min(numRows, (int)selection.size());
+        std::cout << "\n===== " << shown << " OF " << selection.size() << " SELECTED ROWS =====" << std::endl;
+
+        for (const auto &name : columnNames)
+        {
+            std::cout << std::setw(15) << name;
+        }
+        std::cout << std::endl;
+
+        for (size_t i = 0; i < columnNames.size(); ++i)
+        {
+            std::cout << std::setw(15) << std::string(14, '-');
+        }
+        std::cout << std::endl;
+
+        for (int i = 0; i < shown; ++i)
+        {
+            RowView row = data[selection[i]];
+            for (size_t c = 0; c < columnNames.size(); ++c)
+            {
+                std::cout << std::setw(15) << row.getValueAsString(c);
+            }
+            std::cout << std::endl;
+        }
+    }
+
     // Method to search for specific values
-    std::vector<size_t> searchValue(const string &columnName, const string &value)
+    RowSelection searchValue(const string &columnName, const string &value)
     {
         vector<size_t> results;
 
-        auto it = find(columnNames.begin(), columnNames.end(), columnName);
-        if (it == columnNames.end())
+        size_t columnIndex = findColumn(columnName);
+        if (columnIndex == Schema::npos)
         {
             std::cout << "Column '" << columnName << "' not found." << std::endl;
-            return results;
+            return RowSelection();
         }
 
-        size_t columnIndex = std::distance(columnNames.begin(), it);
+        const Column &column = data.getColumn(columnIndex);
+        bool textColumn = column.getType() == DataType::STRING || column.getType() == DataType::CATEGORY;
 
         for (size_t i = 0; i < data.size(); ++i)
         {
-            std::string cellValue = data[i].getValueAsString(columnIndex);
-            if (cellValue == value)
+            // Text cells are compared in place; other types are formatted first
+            bool equal = textColumn ? column.getView(i) == value
+                                    : column.getAsString(i) == value;
+            if (equal)
             {
                 results.push_back(i);
             }
         }
 
-        return results;
+        return RowSelection(std::move(results));
     }
 
     // Method to filter data based on criteria
     // Method to filter data based on criteria
-    vector<Dato> filterData(const string &columnName,
+    // Rows where 'columnName <operation> value' holds. The result only holds row
+    // indices; read the rows through getData() or pass it to the reports.
+    RowSelection filterData(const string &columnName,
                             const string &operation,
                             const string &value)
     {
-        vector<Dato> filtered;
-
         // 1. Verify column existence
-        auto it = find(columnNames.begin(), columnNames.end(), columnName);
-        if (it == columnNames.end())
+        size_t columnIndex = findColumn(columnName);
+        if (columnIndex == Schema::npos)
         {
             std::cout << "Column '" << columnName << "' not found." << std::endl;
-            return filtered;
+            return RowSelection();
         }
 
-        size_t columnIndex = distance(columnNames.begin(), it);
-        DataType type = columnTypes[columnIndex];
-
-        // 2. Pre-calculate comparison values (Optimization)
-        // We convert the user input 'value' ONCE, instead of every iteration.
-        double numCompareVal = 0.0;
-        long long dateCompareVal = 0;
-
-        if (type == DataType::INTEGER || type == DataType::FLOAT)
+        // 2. Resolve type, operator and value ONCE into a typed kernel
+        ColumnPredicate predicate;
+        string error;
+        if (!ColumnPredicate::compile(data.getColumn(columnIndex), operation, value, predicate, error))
         {
-            try
-            {
-                numCompareVal = stod(value);
-            }
-            catch (...)
-            {
-                numCompareVal = 0.0;
-            }
+            std::cout << error << std::endl;
+            return RowSelection();
         }
-        else if (type == DataType::DATE)
+
+        // 3. Scan the column in parallel word ranges; rows are not copied
+        return predicate.select(scheduler.get());
+    }
+
+    // Rows matching a combination of conditions joined with AND/OR and
+    // parentheses (see FilterExpression), e.g.
+    //   Distancia_KM > 200 AND (Tipo_Vehiculo = Camioneta OR Peso_Carga_KG >= 800)
+    RowSelection filterByExpression(const string &expression)
+    {
+        FilterExpression compiled;
+        string error;
+        if (!FilterExpression::parse(data, expression, compiled, error))
         {
-            // Utilizes the existing helper function in your code
-            dateCompareVal = dateToComparable(value);
+            std::cout << "Invalid filter: " << error << std::endl;
+            return RowSelection();
         }
+        return compiled.select(scheduler.get());
+    }
 
-        // 3. Iterate through rows
-        for (const auto &row : data)
-        {
-            bool matches = false;
+    // Count/sum/min/max/variance of a numeric column (or of the selected rows)
+    NumericSummary summarizeNumericColumn(size_t columnIndex, const RowSelection *selection = nullptr) const
+    {
+        return summarizeColumn(data.getColumn(columnIndex), selection ? &selection->getRows() : nullptr);
+    }
 
-            if (type == DataType::INTEGER || type == DataType::FLOAT)
-            {
-                // --- NUMERIC COMPARISON ---
-                double cellValue = row.getNumericValue(columnIndex);
-
-                if (operation == "==" || operation == "=")
-                    matches = (std::abs(cellValue - numCompareVal) < 1e-9);
-                else if (operation == ">")
-                    matches = (cellValue > numCompareVal);
-                else if (operation == "<")
-                    matches = (cellValue < numCompareVal);
-                else if (operation == ">=")
-                    matches = (cellValue >= numCompareVal);
-                else if (operation == "<=")
-                    matches = (cellValue <= numCompareVal);
-                else if (operation == "!=")
-                    matches = (std::abs(cellValue - numCompareVal) >= 1e-9);
-            }
-            else if (type == DataType::DATE)
-            {
-                // --- DATE COMPARISON (New Logic) ---
-                // Convert the cell value to a comparable integer (YYYYMMDD)
-                long long cellDate = dateToComparable(row.getValueAsString(columnIndex));
-
-                if (operation == "==" || operation == "=")
-                    matches = (cellDate == dateCompareVal);
-                else if (operation == "!=")
-                    matches = (cellDate != dateCompareVal);
-                else if (operation == ">")
-                    matches = (cellDate > dateCompareVal);
-                else if (operation == "<")
-                    matches = (cellDate < dateCompareVal);
-                else if (operation == ">=")
-                    matches = (cellDate >= dateCompareVal);
-                else if (operation == "<=")
-                    matches = (cellDate <= dateCompareVal);
-            }
-            else
-            {
-                // --- STRING / CATEGORY COMPARISON ---
-                std::string cellValue = row.getValueAsString(columnIndex);
-
-                if (operation == "==" || operation == "=")
-                    matches = (cellValue == value);
-                else if (operation == "!=")
-                    matches = (cellValue != value);
-                else if (operation == "contains")
-                    matches = (cellValue.find(value) != string::npos);
-                // Added basic alphabetical support
-                else if (operation == ">")
-                    matches = (cellValue > value);
-                else if (operation == "<")
-                    matches = (cellValue < value);
-            }
+    // Percentiles (0-100, e.g. {50, 90, 99}) of a numeric column or of the
+    // selected rows, linearly interpolated; computed by selection, not sorting
+    vector<double> getPercentiles(size_t columnIndex, const vector<double> &percents,
+                                  const RowSelection *selection = nullptr) const
+    {
+        vector<double> values;
+        const Column &column = data.getColumn(columnIndex);
+        values.reserve(selection ? selection->size() : column.size());
+        forEachNumericValue(column, selection, [&](double v)
+                            { values.push_back(v); });
+        return percentiles(values, percents);
+    }
+
+    // Count, nulls, distinct estimate, moments and quantiles of a whole column.
+    // Computed on first request and reused until the next load; rows added by
+    // appendNewRows are folded in without rescanning the others (only exact
+    // quantiles are recomputed, and only when asked for).
+    const ColumnStats &getColumnStats(size_t columnIndex)
+    {
+        if (columnStats.size() != columnNames.size())
+            columnStats.assign(columnNames.size(), ColumnStats());
+
+        // Cached stats (e.g. from a snapshot) don't need the column itself
+        ColumnStats &stats = columnStats[columnIndex];
+        if (stats.rows < data.size())
+            updateColumnStats(stats, data.getColumn(columnIndex));
+        if (!stats.quantilesReady)
+            computeColumnQuantiles(stats, data.getColumn(columnIndex));
+        return stats;
+    }
+
+    // Most frequent values of a column and how many distinct values it has
+    struct FrequencyReport
+    {
+        vector<pair<string, size_t>> top; // most frequent first (ties: smaller value first)
+        size_t distinct = 0;
+
+        // Set when the report comes from the sketches: each count in 'top' is
+        // an upper bound and bounds[i] the matching lower one, 'distinct' has
+        // a relative standard error of 'distinctError', and values not listed
+        // occur at most 'unlistedBound' times each
+        bool approximate = false;
+        vector<size_t> bounds;
+        double distinctError = 0.0;
+        size_t unlistedBound = 0;
+    };
+
+    // The 'k' most frequent non-empty values of a column. Categories use the
+    // cached counts per dictionary code; other types are counted on their typed
+    // values (views for text) in flat hash tables built in parallel. Only the
+    // top k are selected and turned into strings. Text columns with more than
+    // exactFrequencyLimit distinct values (HyperLogLog estimate) are read from
+    // their heavy-hitter sketch instead, without another pass.
+    FrequencyReport getFrequencies(size_t columnIndex, size_t k)
+    {
+        const Column &column = data.getColumn(columnIndex);
+        auto labelOf = [&column](const auto &entry)
+        { return column.getAsString(entry.firstRow); };
 
-            if (matches)
+        switch (column.getType())
+        {
+        case DataType::CATEGORY:
+        {
+            const auto &dictionary = column.getDictionary();
+            const vector<size_t> &counts = getColumnStats(columnIndex).categoryCounts;
+            auto better = [&](uint32_t a, uint32_t b)
+            { return counts[a] != counts[b] ? counts[a] > counts[b] : dictionary[a] < dictionary[b]; };
+            TopK<uint32_t, decltype(better)> best(k, better);
+
+            FrequencyReport report;
+            for (uint32_t d = 0; d < counts.size(); ++d)
             {
-                filtered.push_back(row);
+                if (counts[d] > 0 && !dictionary[d].empty())
+                {
+                    report.distinct++;
+                    best.offer(d);
+                }
             }
+            for (uint32_t d : best.take())
+                report.top.emplace_back(dictionary[d], counts[d]);
+            return report;
+        }
+        case DataType::STRING:
+            if (getColumnStats(columnIndex).distinct > exactFrequencyLimit)
+                return sketchedFrequencies(getColumnStats(columnIndex), k);
+            return countFrequencies<string_view, StringViewHash>(
+                column.size(), k, [&column](size_t r, string_view &key)
+                { key = column.getView(r); return !key.empty(); },
+                [](const auto &entry)
+                { return string(entry.key); });
+        case DataType::DATE:
+            return countFrequencies<int64_t, IntegerHash>(
+                column.size(), k, [&column](size_t r, int64_t &key)
+                { key = column.getDates()[r]; return !column.isNull(r); },
+                labelOf);
+        case DataType::INTEGER:
+            return countFrequencies<int64_t, IntegerHash>(
+                column.size(), k, [&column](size_t r, int64_t &key)
+                { key = column.getInts()[r]; return !column.isNull(r); },
+                labelOf);
+        case DataType::FLOAT:
+            // Keyed by bit pattern, with -0.0 folded into 0.0. Labels are the
+            // shortest text that reads back as the same value, so values that
+            // getAsString would round alike (1.001, 1.004) stay apart.
+            return countFrequencies<int64_t, IntegerHash>(
+                column.size(), k, [&column](size_t r, int64_t &key)
+                {
+                    double value = column.getFloats()[r] + 0.0;
+                    memcpy(&key, &value, sizeof(key));
+                    return !column.isNull(r); },
+                [](const auto &entry)
+                {
+                    double value;
+                    memcpy(&value, &entry.key, sizeof(value));
+                    char text[32];
+                    auto result = to_chars(text, text + sizeof(text), value);
+                    return string(text, result.ptr); });
         }
+        return FrequencyReport();
+    }
 
-        return filtered;
+    // Bring the statistics of every column up to date at once, in parallel
+    // (reports do this for the columns they show before printing anything)
+    void prepareColumnStats()
+    {
+        vector<size_t> all(columnNames.size());
+        iota(all.begin(), all.end(), size_t(0));
+        prepareColumnStats(all);
+    }
+
+    // Approximate quantiles of a numeric column from the sketch built at load
+    // time (nullptr for other columns or when sketches are off). Sketches from
+    // other analyzers, e.g. one per file, can be merged into a copy.
+    const QuantileSketch *getQuantileSketch(size_t columnIndex) const
+    {
+        if (columnIndex >= sketches.size() || sketches[columnIndex].empty())
+            return nullptr;
+        return &sketches[columnIndex];
     }
 
     // Getters
-    const vector<Dato> &getData() const { return data; }
+    const ColumnTable &getData() const { return data; }
+    const shared_ptr<const Schema> &getSchema() const { return data.getSchema(); }
     const vector<std::string> &getColumnNames() const { return columnNames; }
     const vector<DataType> &getColumnTypes() const { return columnTypes; }
     size_t getRowCount() const { return data.size(); }
+    size_t getParseFailureCount(size_t columnIndex) const { return data.getColumn(columnIndex).getParseFailureCount(); }
     size_t getColumnCount() const { return columnNames.size(); }
 
 private:
-    // Helper method to parse a line based on delimiter
-    vector<string> parseLine(const string &line)
+    // Hash lookup of a column index by name (Schema::npos if missing)
+    size_t findColumn(const string &columnName) const
+    {
+        return data.getSchema()->indexOf(columnName);
+    }
+
+    // Draw one bar per bin, normalized to 40 characters for the fullest bin
+    static void drawHistogram(const string &columnName, double minVal, double maxVal, const vector<size_t> &binCounts)
     {
-        vector<string> result;
-        stringstream ss(line);
-        string cell;
+        size_t bins = binCounts.size();
+        double step = (maxVal - minVal) / bins;
+
+        cout << "\n===== HISTOGRAMA: " << columnName << " =====" << endl;
+        cout << "Rango: [" << minVal << " a " << maxVal << "]\n"
+             << endl;
 
-        while (getline(ss, cell, delimiter))
+        size_t maxCount = *max_element(binCounts.begin(), binCounts.end());
+
+        for (size_t i = 0; i < bins; ++i)
         {
-            cell.erase(0, cell.find_first_not_of(" \t\r\n"));
-            cell.erase(cell.find_last_not_of(" \t\r\n") + 1);
-            result.push_back(cell);
+            double binStart = minVal + (i * step);
+            double binEnd = minVal + ((i + 1) * step);
+
+            // Etiqueta del rango
+            cout << fixed << setprecision(1) << setw(8) << binStart << " - " << setw(8) << binEnd << " | ";
+
+            // Barra ASCII (normalizada a 40 caracteres de largo)
+            size_t barLength = (maxCount > 0) ? (binCounts[i] * 40 / maxCount) : 0;
+            cout << string(barLength, '*') << " (" << binCounts[i] << ")\n";
         }
-        return result;
+        cout << string(60, '-') << endl;
     }
 
-    // Helper method to detect data types for each column
-    void detectDataTypes(const vector<vector<string>> &rawData)
+    // Summarize a converted chunk for a streaming pass; its rows are dropped after
+    void summarizeStreamChunk(LoadChunk &chunk, const string &filter, StreamChunkResult &partial)
     {
-        columnTypes.resize(columnNames.size());
+        size_t columnCount = chunk.table.getColumnCount();
+        partial.rows = chunk.table.size();
+        partial.columns.resize(columnCount);
+        for (size_t i = 0; i < columnCount; ++i)
+        {
+            partial.columns[i].add(chunk.table.getColumn(i));
+            if (i < chunk.sketches.size())
+                partial.columns[i].sketch = std::move(chunk.sketches[i]);
+        }
 
-        for (size_t col = 0; col < columnNames.size(); ++col)
+        // Category codes differ per chunk, so the filter is compiled per chunk
+        if (!filter.empty())
         {
-            columnTypes[col] = inferDataType(rawData, col);
+            FilterExpression expression;
+            string error;
+            if (FilterExpression::parse(chunk.table, filter, expression, error))
+                partial.matched = expression.count();
         }
     }
 
-    // Helper method to infer data type for a column
-    DataType inferDataType(const vector<vector<std::string>> &rawData, size_t columnIndex)
+    // Replace the current table with the snapshot in 'snapshotFile' (only if it
+    // was made from exactly 'expected', when given)
+    bool restoreSnapshot(const string &snapshotFile, const SnapshotKey *expected)
     {
-        map<DataType, int> typeScores;
-
-        for (const auto &row : rawData)
-        {
-            if (columnIndex < row.size() && !row[columnIndex].empty())
-            {
-                const std::string &value = row[columnIndex];
+        SnapshotContents contents;
+        if (!::openSnapshot(snapshotFile, expected, contents))
+            return false;
 
-                if (isInteger(value))
-                {
-                    typeScores[DataType::INTEGER]++;
-                }
-                else if (isFloat(value))
-                {
-                    typeScores[DataType::FLOAT]++;
-                }
-                else if (isDate(value))
-                {
-                    typeScores[DataType::DATE]++;
-                }
-                else
-                {
-                    typeScores[DataType::STRING]++;
-                }
-            }
-        }
+        data = std::move(contents.table);
+        columnNames = data.getColumnNames();
+        columnTypes = data.getColumnTypes();
+        columnStats = std::move(contents.stats);
+        sketches = std::move(contents.sketches);
+        filename = contents.key.path;
+        loadedBytes = contents.key.size;
+        return true;
+    }
 
-        // Determine the most likely type
-        DataType bestType = DataType::STRING;
-        int maxScore = 0;
+    // Call whenever the table is replaced (appended rows are folded in instead)
+    void invalidateColumnStats()
+    {
+        columnStats.clear();
+    }
 
-        for (const auto &pair : typeScores)
+    // Stitch converted chunks onto the table in file order and merge their
+    // sketches. With 'loadedOnly', the chunks hold just the columns read so far.
+    void appendChunks(vector<LoadChunk> &chunks, bool loadedOnly = false)
+    {
+        if (sketches.size() != columnNames.size())
+            sketches.assign(columnNames.size(), QuantileSketch(sketchAccuracy));
+        size_t strayQuotes = 0;
+        for (auto &chunk : chunks)
         {
-            if (pair.second > maxScore)
-            {
-                maxScore = pair.second;
-                bestType = pair.first;
-            }
+            if (loadedOnly)
+                data.appendLoadedColumns(std::move(chunk.table));
+            else
+                data.appendTable(std::move(chunk.table));
+            for (size_t i = 0; i < chunk.sketches.size(); ++i)
+                sketches[i].merge(chunk.sketches[i]);
+            strayQuotes += chunk.strayQuotes;
         }
-
-        if (bestType == DataType::STRING && mightBeCategory(rawData, columnIndex))
+        if (strayQuotes > 0)
         {
-            bestType = DataType::CATEGORY;
+            std::cout << "Warning: " << strayQuotes << " quote(s) inside unquoted fields"
+                      << " were read as plain text" << std::endl;
         }
-        return bestType;
     }
 
-    // Helper methods to check data types
-    bool isInteger(const string &str)
+    // Warn about cells that failed to parse since the counts in 'before'
+    // (columns not read yet report theirs when they are loaded)
+    void reportParseFailures(const vector<size_t> &before)
     {
-        if (str.empty())
-            return false;
-        size_t start = (str[0] == '-' || str[0] == '+') ? 1 : 0;
-        return start < str.length() &&
-               std::all_of(str.begin() + start, str.end(), ::isdigit);
+        for (size_t i = 0; i < columnNames.size(); ++i)
+        {
+            if (data.isColumnLoaded(i))
+                warnParseFailures(columnNames[i], columnTypes[i], data.getColumn(i).getParseFailureCount() - before[i]);
+        }
     }
 
-    bool isFloat(const std::string &str)
+    static void warnParseFailures(const string &name, DataType type, size_t failures)
     {
-        try
+        if (failures > 0)
         {
-            std::stof(str);
-            return str.find('.') != std::string::npos;
+            std::cout << "Warning: " << failures << " value(s) in column '" << name
+                      << "' are not valid " << dataTypeToString(type)
+                      << " values and were stored as null" << std::endl;
         }
-        catch (...)
+    }
+
+    // One byte range of a file, converted into a single column
+    struct ColumnChunk
+    {
+        size_t begin = 0;
+        size_t end = 0;
+        Column column;
+    };
+
+    // Loader for the columns a projected load left out: converts column 'index'
+    // from the records of the same chunks, in parallel, keeping the mapping of
+    // the file as it was loaded alive until the table is gone
+    function<void(size_t, Column &)> deferredColumnLoader(shared_ptr<MappedFile> file,
+                                                          const vector<LoadChunk> &chunks,
+                                                          shared_ptr<const Schema> schema) const
+    {
+        vector<pair<size_t, size_t>> ranges;
+        for (const auto &chunk : chunks)
+            ranges.emplace_back(chunk.begin, chunk.end);
+
+        return [file, ranges, schema, tasks = scheduler, separator = delimiter,
+                intern = internStrings](size_t index, Column &column)
         {
-            return false;
+            string_view text = file->view();
+            size_t columnCount = schema->getColumnCount();
+            DataType type = schema->getColumnTypes()[index];
+            vector<char> wanted(columnCount, 0);
+            wanted[index] = 1;
+
+            vector<ColumnChunk> parts(ranges.size());
+            for (size_t i = 0; i < parts.size(); ++i)
+            {
+                parts[i].begin = ranges[i].first;
+                parts[i].end = ranges[i].second;
+            }
+            tasks->parallelFor(parts.size(), [&](size_t i)
+                               {
+                                   ColumnChunk &part = parts[i];
+                                   part.column = Column(type);
+                                   part.column.setStringInterning(intern);
+                                   CSVTokenizer tokenizer(text.substr(0, part.end), separator, part.begin);
+                                   tokenizer.setWantedFields(&wanted);
+                                   vector<string_view> cells;
+                                   // Same row rule as convertChunk, so the rows line up
+                                   while (tokenizer.next(cells))
+                                   {
+                                       if (cells.size() == columnCount)
+                                           part.column.append(cells[index]);
+                                   } });
+
+            column = Column(type);
+            for (auto &part : parts)
+                column.appendFrom(std::move(part.column));
+            warnParseFailures(schema->getColumnNames()[index], type, column.getParseFailureCount());
+        };
+    }
+
+    // Split [bodyStart, end of file) into byte ranges that start at a record boundary
+    vector<LoadChunk> splitIntoChunks(string_view text, size_t bodyStart) const
+    {
+        size_t bodySize = text.size() - bodyStart;
+        size_t threads = scheduler->getWorkerCount();
+        size_t chunkCount = max<size_t>(1, min(threads, bodySize / minChunkBytes));
+
+        vector<size_t> boundaries = splitRecordAligned(text, bodyStart, chunkCount, delimiter);
+        vector<LoadChunk> chunks(boundaries.size() - 1);
+        for (size_t i = 0; i + 1 < boundaries.size(); ++i)
+        {
+            chunks[i].begin = boundaries[i];
+            chunks[i].end = boundaries[i + 1];
         }
+        return chunks;
     }
 
-    bool isDate(const std::string &str)
+    // Run 'work' on every chunk as scheduler tasks, while the calling thread
+    // keeps the progress callback up to date through 'poll'. Returns false if
+    // cancel() skipped some of them.
+    template <typename Chunk, typename Work, typename Poll>
+    bool runChunks(vector<Chunk> &chunks, Work work, Poll poll)
     {
-        // Simple date pattern check (YYYY-MM-DD)
-        return std::regex_match(str, std::regex(R"(\d{4}-\d{2}-\d{2})"));
+        bool finished = scheduler->parallelFor(chunks.size(), [&](size_t i)
+                                               { work(chunks[i]); },
+                                               &cancellation, poll);
+        poll();
+        return finished && !cancellation.isCancelled();
     }
-    // Helper to convert date strings to a comparable integer (YYYYMMDD)
-    long long dateToComparable(string dateStr)
+
+    // Run 'work(task)' for tasks 0..count-1 on the scheduler; the first
+    // exception is rethrown
+    template <typename Work>
+    void runTasks(size_t count, Work work) const
     {
-        string cleanDate;
-        for (char c : dateStr)
-            if (isdigit(c))
-                cleanDate += c;
+        scheduler->parallelFor(count, work);
+    }
 
-        // If format is DDMMAAAA (e.g. 31012023), convert to AAAAMMDD (20230131)
-        if (cleanDate.length() == 8)
+    // Read the pending (projected or snapshot) columns among 'columns' on this
+    // thread. Parallel work must not be the first to touch a column: its
+    // loader runs a parallel call inside the column's once_flag, and a task
+    // of the same report reaching that flag from a worker could block on it.
+    void loadColumns(const vector<size_t> &columns) const
+    {
+        for (size_t column : columns)
+            data.getColumn(column);
+    }
+
+    // Indices of the columns of the given types, in table order
+    vector<size_t> columnsOfType(initializer_list<DataType> types) const
+    {
+        vector<size_t> columns;
+        for (size_t i = 0; i < columnTypes.size(); ++i)
         {
-            // Check if it looks like ISO (start with 19 or 20) or DD/MM
-            // Heuristic: If first 4 digits are < 1900, it's likely DDMMYYYY
-            int firstPart = stoi(cleanDate.substr(0, 4));
-            if (firstPart < 1900)
-            {
-                string day = cleanDate.substr(0, 2);
-                string month = cleanDate.substr(2, 2);
-                string year = cleanDate.substr(4, 4);
-                return stoll(year + month + day);
-            }
+            if (find(types.begin(), types.end(), columnTypes[i]) != types.end())
+                columns.push_back(i);
         }
-        // If it's already YYYYMMDD or unknown, return as is
-        try
+        return columns;
+    }
+
+    // Bring the cached statistics of 'columns' up to date with one task per
+    // column, or per statsRangeRows rows of a large column. Ranges are merged
+    // in row order as they finish, so the result does not depend on timing;
+    // the quantiles still missing are then computed one task per column.
+    void prepareColumnStats(const vector<size_t> &columns)
+    {
+        if (columnStats.size() != columnNames.size())
+            columnStats.assign(columnNames.size(), ColumnStats());
+
+        // Ranges of one column waiting for the ones before them to be merged
+        struct PendingColumn
+        {
+            size_t column = 0;
+            size_t first = 0;
+            size_t merged = 0;
+            vector<optional<ColumnStats>> parts;
+            std::mutex lock;
+        };
+        vector<PendingColumn> pending(columns.size());
+        vector<pair<size_t, size_t>> tasks; // (pending column, range)
+        vector<size_t> scanned;             // columns the tasks will read
+        for (size_t c = 0; c < columns.size(); ++c)
         {
-            return stoll(cleanDate);
+            pending[c].column = columns[c];
+            pending[c].first = columnStats[columns[c]].rows;
+            if (pending[c].first < data.size() || !columnStats[columns[c]].quantilesReady)
+                scanned.push_back(columns[c]);
+            if (pending[c].first >= data.size())
+                continue;
+            size_t ranges = (data.size() - pending[c].first + statsRangeRows - 1) / statsRangeRows;
+            pending[c].parts.resize(ranges);
+            for (size_t r = 0; r < ranges; ++r)
+                tasks.emplace_back(c, r);
         }
-        catch (...)
+
+        loadColumns(scanned);
+        runTasks(tasks.size(), [&](size_t task)
+                 {
+                     PendingColumn &column = pending[tasks[task].first];
+                     ColumnStats &stats = columnStats[column.column];
+                     const Column &values = data.getColumn(column.column);
+                     if (column.parts.size() == 1)
+                     {
+                         updateColumnStats(stats, values);
+                         return;
+                     }
+
+                     size_t range = tasks[task].second;
+                     size_t first = column.first + range * statsRangeRows;
+                     ColumnStats part = columnStatsOfRows(values, first, min(first + statsRangeRows, data.size()));
+
+                     lock_guard<std::mutex> guard(column.lock);
+                     column.parts[range] = std::move(part);
+                     while (column.merged < column.parts.size() && column.parts[column.merged])
+                     {
+                         mergeColumnStats(stats, *column.parts[column.merged], values);
+                         column.parts[column.merged++].reset();
+                     } });
+
+        vector<size_t> stale;
+        for (size_t column : columns)
         {
-            return 0;
+            if (!columnStats[column].quantilesReady)
+                stale.push_back(column);
         }
+        runTasks(stale.size(), [&](size_t task)
+                 { computeColumnQuantiles(columnStats[stale[task]], data.getColumn(stale[task])); });
     }
 
-    bool mightBeCategory(const vector<vector<string>> &rawData, size_t columnIndex)
+    // Helper method to detect data types for each column.
+    // One fused pass over the sampled records classifies every column at once.
+    // With 'exactStrata' off, the strata windows start after the first newline
+    // past their target instead of tracking quotes from the top of the file, so
+    // only the sampled bytes are read (a window that starts inside a quoted
+    // field loses a record, which the cell-count check drops).
+    vector<DataType> detectDataTypes(string_view text, size_t bodyStart, size_t columnCount,
+                                     bool exactStrata = true)
     {
-        set<string> uniqueValues;
+        size_t plannedRows = sampling.headRows + sampling.strata * sampling.rowsPerStratum;
 
-        for (const auto &row : rawData)
+        TypeSample sample;
+        sample.typeScores.assign(columnCount, array<int, 4>{0, 0, 0, 0});
+        sample.distinctValues.resize(columnCount);
+        sample.highCardinality.assign(columnCount, 0);
+        // Above this many distinct values a column can never be a category
+        sample.distinctLimit = max<size_t>(10, static_cast<size_t>(plannedRows * 0.1));
+
+        size_t headEnd = sampleRecords(text, bodyStart, text.size(), sampling.headRows, sample);
+
+        if (headEnd < text.size() && sampling.strata > 0)
         {
-            if (columnIndex < row.size() && !row[columnIndex].empty())
+            vector<size_t> strata;
+            if (exactStrata)
+                strata = splitRecordAligned(text, bodyStart, sampling.strata + 1, delimiter);
+            else
+            {
+                size_t bodySize = text.size() - bodyStart;
+                strata.push_back(bodyStart);
+                for (size_t i = 1; i <= sampling.strata; ++i)
+                {
+                    size_t newline = text.find('\n', bodyStart + bodySize * i / (sampling.strata + 1));
+                    if (newline == string_view::npos)
+                        break;
+                    strata.push_back(newline + 1);
+                }
+                strata.push_back(text.size());
+            }
+            for (size_t i = 1; i + 1 < strata.size(); ++i)
             {
-                uniqueValues.insert(row[columnIndex]);
+                // Skip windows the head (or the previous window) already covered
+                if (strata[i] < headEnd)
+                    continue;
+                headEnd = sampleRecords(text, strata[i], strata[i + 1], sampling.rowsPerStratum, sample);
             }
         }
 
-        // If there are few unique values compared to total rows, it might be categorical
-        return uniqueValues.size() <= max(10, (int)(rawData.size() * 0.1));
+        vector<DataType> types(columnCount, DataType::STRING);
+        for (size_t col = 0; col < columnCount; ++col)
+        {
+            size_t uniqueCount = sample.highCardinality[col] ? sample.rows : sample.distinctValues[col].size();
+            types[col] = inferDataType(sample.typeScores[col], uniqueCount, sample.rows);
+        }
+        return types;
     }
 
-    void convertRawDataToDato(const vector<vector<string>> &rawData,
-                              std::function<void(int)> progressCallback,
-                              std::uintmax_t &bytesRead,
-                              std::uintmax_t totalWork,
-                              std::uintmax_t avgRowBytes)
+    // Score up to 'maxRows' valid records of text[begin, end); returns where it stopped
+    size_t sampleRecords(string_view text, size_t begin, size_t end, size_t maxRows, TypeSample &sample)
     {
-        for (size_t idx = 0; idx < rawData.size(); ++idx)
+        CSVTokenizer tokenizer(text.substr(0, end), delimiter, begin);
+        vector<string_view> cells;
+        size_t taken = 0;
+
+        while (taken < maxRows && tokenizer.next(cells))
         {
-            const auto &row = rawData[idx];
-            Dato dato(columnNames, columnTypes);
+            if (cells.size() != sample.typeScores.size())
+                continue;
 
-            for (size_t i = 0; i < row.size() && i < columnNames.size(); ++i)
+            for (size_t col = 0; col < cells.size(); ++col)
             {
-                try
-                {
-                    dato.setValueFromString(i, row[i]);
-                }
-                catch (const std::exception &e)
-                {
-                    // If conversion fails, set as string
-                    dato.setValue(i, row[i]);
-                }
-            }
+                string_view value = cells[col];
+                if (value.empty())
+                    continue;
 
-            data.push_back(dato);
+                // Scores indexed by DataType (INTEGER, FLOAT, STRING, DATE)
+                sample.typeScores[col][static_cast<int>(classifyCell(value))]++;
 
-            // Update unified progress: add estimated bytes for this row conversion
-            if (progressCallback && totalWork > 0)
-            {
-                bytesRead += avgRowBytes;
-                int percent = static_cast<int>((double)bytesRead * 100.0 / (double)totalWork);
-                if (percent > 99)
-                    percent = 99; // leave 100 for finalization
-                try
-                {
-                    progressCallback(percent);
-                }
-                catch (...)
+                // Stop tracking distinct values as soon as the column can't be a category
+                if (!sample.highCardinality[col])
                 {
+                    auto &distinct = sample.distinctValues[col];
+                    distinct.insert(StringViewHash()(value));
+                    if (distinct.size() > sample.distinctLimit)
+                    {
+                        sample.highCardinality[col] = 1;
+                        unordered_set<uint64_t>().swap(distinct);
+                    }
                 }
             }
+            taken++;
         }
+
+        sample.rows += taken;
+        return tokenizer.position();
     }
 
-    // Helper method to count non-null values in a column
-    int getNonNullCount(size_t columnIndex)
+    // Helper method to infer data type for a column from its scores
+    DataType inferDataType(const array<int, 4> &typeScores, size_t uniqueCount, size_t rowCount)
     {
-        int count = 0;
-        for (const auto &row : data)
+        // Determine the most likely type (ties keep the lower DataType, as before)
+        DataType bestType = DataType::STRING;
+        int maxScore = 0;
+
+        for (size_t t = 0; t < typeScores.size(); ++t)
         {
-            std::string value = row.getValueAsString(columnIndex);
-            if (!value.empty() && value != "N/A")
+            if (typeScores[t] > maxScore)
             {
-                count++;
+                maxScore = typeScores[t];
+                bestType = static_cast<DataType>(t);
             }
         }
-        return count;
+
+        if (bestType == DataType::STRING && mightBeCategory(uniqueCount, rowCount))
+        {
+            bestType = DataType::CATEGORY;
+        }
+        return bestType;
     }
 
-    // Helper method to print statistics for a numeric column
-    void printColumnStatistics(size_t columnIndex)
+    // Helper method to classify one non-empty cell in a single pass:
+    //   INTEGER  [+-]digits
+    //   FLOAT    [+-]digits with one '.', optional exponent
+    //   DATE     YYYY-MM-DD
+    //   STRING   anything else
+    static DataType classifyCell(string_view str)
     {
-        std::vector<double> values;
+        const unsigned char *p = reinterpret_cast<const unsigned char *>(str.data());
+        size_t n = str.size();
+
+        auto isDigit = [](unsigned char c)
+        { return static_cast<unsigned char>(c - '0') < 10; };
 
-        for (const auto &row : data)
+        // Fixed-width dates, year first (YYYY-MM-DD) or day first (DD/MM/YYYY)
+        if (n == 10 && isDateSeparator(p[4]) && p[7] == p[4])
         {
-            if (row.isNumericColumn(columnIndex))
-            {
-                double val = row.getNumericValue(columnIndex);
-                values.push_back(val);
-            }
+            bool digits = isDigit(p[0]) & isDigit(p[1]) & isDigit(p[2]) & isDigit(p[3]) &
+                          isDigit(p[5]) & isDigit(p[6]) & isDigit(p[8]) & isDigit(p[9]);
+            return digits ? DataType::DATE : DataType::STRING;
+        }
+        if (n == 10 && isDateSeparator(p[2]) && p[5] == p[2])
+        {
+            bool digits = isDigit(p[0]) & isDigit(p[1]) & isDigit(p[3]) & isDigit(p[4]) &
+                          isDigit(p[6]) & isDigit(p[7]) & isDigit(p[8]) & isDigit(p[9]);
+            return digits ? DataType::DATE : DataType::STRING;
         }
 
-        if (values.empty())
-            return;
+        size_t i = (p[0] == '-' || p[0] == '+') ? 1 : 0;
+        size_t digitCount = 0;
+        size_t dotCount = 0;
+
+        // Mantissa: digits with at most one '.'
+        for (; i < n; ++i)
+        {
+            unsigned char c = p[i];
+            if (isDigit(c))
+                digitCount++;
+            else if (c == '.')
+                dotCount++;
+            else
+                break;
+        }
+
+        if (digitCount == 0 || dotCount > 1)
+            return DataType::STRING;
+        if (i == n)
+            return dotCount == 0 ? DataType::INTEGER : DataType::FLOAT;
+
+        // Optional exponent, only for values that already have a decimal point
+        if (dotCount == 1 && (p[i] == 'e' || p[i] == 'E'))
+        {
+            ++i;
+            if (i < n && (p[i] == '-' || p[i] == '+'))
+                ++i;
+            size_t exponentStart = i;
+            while (i < n && isDigit(p[i]))
+                ++i;
+            if (i == n && i > exponentStart)
+                return DataType::FLOAT;
+        }
+        return DataType::STRING;
+    }
+
+    // A text column is a category when at most 10% of the sampled rows (or
+    // 10 values) are distinct
+    bool mightBeCategory(size_t uniqueCount, size_t rowCount)
+    {
+        // If there are few unique values compared to total rows, it might be categorical
+        return uniqueCount <= static_cast<size_t>(max(10, (int)(rowCount * 0.1)));
+    }
+
+    // Convert the records of one chunk into a chunk-local table
+    // With 'wanted', only the flagged columns are filled (a projected load)
+    void convertChunk(string_view text, LoadChunk &chunk,
+                      const shared_ptr<const Schema> &schema,
+                      std::atomic<std::uintmax_t> &bytesConverted,
+                      const vector<char> *wanted = nullptr)
+    {
+        chunk.table.setSchema(schema);
+        chunk.table.setStringInterning(internStrings);
+
+        CSVTokenizer tokenizer(text.substr(0, chunk.end), delimiter, chunk.begin);
+        tokenizer.setWantedFields(wanted);
+        vector<size_t> columnsToFill;
+        for (size_t i = 0; wanted && i < wanted->size(); ++i)
+        {
+            if ((*wanted)[i])
+                columnsToFill.push_back(i);
+        }
+        vector<string_view> cells;
+        size_t reported = chunk.begin;
 
-        std::sort(values.begin(), values.end());
+        while (tokenizer.next(cells))
+        {
+            // Rows with the wrong number of cells are skipped
+            if (cells.size() == schema->getColumnCount())
+            {
+                if (wanted)
+                    chunk.table.appendRow(cells, columnsToFill);
+                else
+                    chunk.table.appendRow(cells);
+            }
 
-        double sum = std::accumulate(values.begin(), values.end(), 0.0);
-        double mean = sum / values.size();
+            if (tokenizer.position() - reported >= 64 * 1024)
+            {
+                bytesConverted += tokenizer.position() - reported;
+                reported = tokenizer.position();
+                if (cancellation.isCancelled())
+                    break; // the caller discards the chunk
+            }
+        }
+        bytesConverted += tokenizer.position() - reported;
+        chunk.strayQuotes = tokenizer.getStrayQuoteCount();
 
-        double variance = 0.0;
-        for (double val : values)
+        // Sketch the chunk's numeric columns while they are still in this worker
+        if (sketchAccuracy > 0)
         {
-            variance += (val - mean) * (val - mean);
+            chunk.sketches.assign(schema->getColumnCount(), QuantileSketch(sketchAccuracy));
+            for (size_t i = 0; i < chunk.sketches.size(); ++i)
+            {
+                chunk.table.getColumn(i).forEachNumeric([&](double v)
+                                                        { chunk.sketches[i].add(v); });
+            }
         }
-        variance /= values.size();
-        double stddev = std::sqrt(variance);
+    }
 
-        double median;
-        if (values.size() % 2 == 0)
+    // Helper method to count non-null values in a column
+    int getNonNullCount(size_t columnIndex)
+    {
+        return static_cast<int>(getColumnStats(columnIndex).count);
+    }
+
+    // Non-null numeric values of a column, restricted to 'selection' if given
+    template <typename F>
+    void forEachNumericValue(const Column &column, const RowSelection *selection, F &&fn) const
+    {
+        if (selection)
+            column.forEachNumeric(selection->getRows(), fn);
+        else
+            column.forEachNumeric(fn);
+    }
+
+    // What printColumnStatistics shows of one numeric column
+    struct NumericColumnReport
+    {
+        NumericSummary summary;
+        Quartiles quarters;
+    };
+
+    // Without a selection the cached statistics are used, so several columns
+    // can be reported on at once only after prepareColumnStats
+    NumericColumnReport numericColumnReport(size_t columnIndex, const RowSelection *selection)
+    {
+        NumericColumnReport report;
+        if (selection)
         {
-            median = (values[values.size() / 2 - 1] + values[values.size() / 2]) / 2.0;
+            // Moments in one vectorized pass; median and quartiles by selection
+            std::vector<double> values;
+            values.reserve(selection->size());
+            forEachNumericValue(data.getColumn(columnIndex), selection, [&](double v)
+                                { values.push_back(v); });
+            report.summary = summarizeValues(values.data(), values.size());
+            report.quarters = quartiles(values);
         }
         else
         {
-            median = values[values.size() / 2];
+            const ColumnStats &stats = getColumnStats(columnIndex);
+            report.summary = stats.summary;
+            report.quarters = stats.quarters;
         }
+        return report;
+    }
+
+    // Helper method to print statistics for a numeric column
+    void printColumnStatistics(size_t columnIndex, const RowSelection *selection = nullptr)
+    {
+        printNumericColumnReport(columnIndex, numericColumnReport(columnIndex, selection));
+    }
+
+    void printNumericColumnReport(size_t columnIndex, const NumericColumnReport &report)
+    {
+        const NumericSummary &summary = report.summary;
+        const Quartiles &quarters = report.quarters;
+        if (summary.empty())
+            return;
 
         std::cout << "Statistics for '" << columnNames[columnIndex] << "':" << std::endl;
-        std::cout << "  Count: " << values.size() << std::endl;
-        std::cout << "  Mean: " << std::fixed << std::setprecision(2) << mean << std::endl;
-        std::cout << "  Median: " << median << std::endl;
-        std::cout << "  Std Dev: " << stddev << std::endl;
-        std::cout << "  Min: " << values.front() << std::endl;
-        std::cout << "  Max: " << values.back() << std::endl;
+        std::cout << "  Count: " << summary.count << std::endl;
+        std::cout << "  Mean: " << std::fixed << std::setprecision(2) << summary.mean << std::endl;
+        std::cout << "  Median: " << quarters.median << std::endl;
+        std::cout << "  Std Dev: " << summary.stddev() << std::endl;
+        std::cout << "  Min: " << summary.min << std::endl;
+        std::cout << "  Max: " << summary.max << std::endl;
 
         // Quartiles
-        if (values.size() >= 4)
+        if (summary.count >= 4)
         {
-            double q1 = values[values.size() / 4];
-            double q3 = values[3 * values.size() / 4];
-            std::cout << "  Q1: " << q1 << std::endl;
-            std::cout << "  Q3: " << q3 << std::endl;
+            std::cout << "  Q1: " << quarters.q1 << std::endl;
+            std::cout << "  Q3: " << quarters.q3 << std::endl;
         }
     }
 
     // Helper method to print frequency analysis for categorical columns
     void printFrequencyAnalysis(size_t columnIndex)
     {
-        // Map to count occurrences of each unique string
-        std::map<std::string, int> frequency;
+        printFrequencyTable(columnIndex, getFrequencies(columnIndex, 20));
+    }
 
-        for (const auto &row : data)
-        {
-            // This is the key: getValueAsString handles the new NamedCategory struct automatically
-            std::string value = row.getValueAsString(columnIndex);
+    // Count the key 'keyOf(row, key)' gives for every row (false skips it) in
+    // one flat table per row range, merged into a single table as the ranges
+    // finish; then only the top k are picked and labeled
+    template <typename Key, typename Hash, typename KeyOf, typename Label>
+    FrequencyReport countFrequencies(size_t rows, size_t k, KeyOf keyOf, Label label) const
+    {
+        FlatCounter<Key, Hash> total;
+        std::mutex totalLock;
+        scheduler->parallelRange(rows, frequencyGrainRows, [&](size_t first, size_t last)
+                                 {
+                                     FlatCounter<Key, Hash> local;
+                                     Key key{};
+                                     for (size_t r = first; r < last; ++r)
+                                     {
+                                         if (keyOf(r, key))
+                                             local.add(key, r);
+                                     }
+                                     lock_guard<std::mutex> guard(totalLock);
+                                     total.merge(local); });
+
+        FrequencyReport report;
+        report.distinct = total.size();
+        for (const auto &entry : total.top(k))
+            report.top.emplace_back(label(entry), entry.count);
+        return report;
+    }
 
-            // Skip empty values if desired
-            if (!value.empty())
-            {
-                frequency[value]++;
-            }
+    static FrequencyReport sketchedFrequencies(const ColumnStats &stats, size_t k)
+    {
+        FrequencyReport report;
+        report.approximate = true;
+        report.distinct = stats.distinct;
+        report.distinctError = HyperLogLog::relativeError();
+        report.unlistedBound = stats.topValues.unlistedBound();
+        for (const auto &hitter : stats.topValues.top(k))
+        {
+            report.top.emplace_back(hitter.value, hitter.count);
+            report.bounds.push_back(hitter.lower);
         }
+        return report;
+    }
+
+    void printFrequencyTable(size_t columnIndex, const FrequencyReport &report)
+    {
+        printFrequencyTable(columnNames[columnIndex], report, data.size());
+    }
 
+    // Percentages are of 'rows'. Sketched reports also state the error of the
+    // distinct count and the range each count lies in.
+    static void printFrequencyTable(const string &name, const FrequencyReport &report, size_t rows)
+    {
         // Display logic
-        std::cout << "Frequency analysis for '" << columnNames[columnIndex] << "':" << std::endl;
+        std::cout << "Frequency analysis for '" << name << "':" << std::endl;
+        if (report.distinctError > 0.0)
+        {
+            std::cout << "Distinct values: ~" << report.distinct << " (HyperLogLog estimate, +/-"
+                      << std::fixed << std::setprecision(1) << report.distinctError * 100.0 << "%)" << std::endl;
+        }
+        if (report.approximate)
+        {
+            std::cout << "Counts from a heavy-hitter sketch: upper bounds, the true count is within Range"
+                      << std::endl;
+        }
         std::cout << std::setw(30) << std::left << "Value"
                   << std::setw(10) << std::right << "Count"
-                  << std::setw(10) << "%" << std::endl;
-        std::cout << std::string(50, '-') << std::endl;
-
-        // Sort by frequency (descending) for better readability
-        std::vector<std::pair<std::string, int>> sortedFreq(frequency.begin(), frequency.end());
-        std::sort(sortedFreq.begin(), sortedFreq.end(),
-                  [](const auto &a, const auto &b)
-                  { return a.second > b.second; });
+                  << std::setw(10) << "%";
+        if (report.approximate)
+            std::cout << std::setw(24) << "Range";
+        std::cout << std::endl;
+        std::cout << std::string(report.approximate ? 74 : 50, '-') << std::endl;
 
-        // Print top 10 (or all)
+        // Print top 20 (or all)
         int displayed = 0;
-        for (const auto &pair : sortedFreq)
+        for (size_t i = 0; i < report.top.size(); ++i)
         {
-            double percentage = (double)pair.second / data.size() * 100.0;
+            const auto &pair = report.top[i];
+            double percentage = (double)pair.second / rows * 100.0;
             std::cout << std::setw(30) << std::left << pair.first.substr(0, 29) // Truncate long names
                       << std::setw(10) << std::right << pair.second
-                      << std::setw(10) << std::fixed << std::setprecision(2) << percentage << "%"
-                      << std::endl;
+                      << std::setw(10) << std::fixed << std::setprecision(2) << percentage << "%";
+            if (report.approximate)
+                std::cout << std::setw(23) << (to_string(report.bounds[i]) + "-" + to_string(pair.second));
+            std::cout << std::endl;
 
             displayed++;
             if (displayed >= 20)
             { // Limit to top 20 to prevent console flooding
-                std::cout << "... (" << (sortedFreq.size() - 20) << " more unique values) ..." << std::endl;
+                if (report.approximate)
+                {
+                    std::cout << "... (~" << (report.distinct > 20 ? report.distinct - 20 : 0)
+                              << " more distinct values; any value not listed occurs at most "
+                              << max(report.unlistedBound, report.top.back().second) << " times) ..." << std::endl;
+                }
+                else
+                {
+                    std::cout << "... (" << (report.distinct - 20) << " more unique values) ..." << std::endl;
+                }
                 break;
             }
         }
@@ -0,0 +1 @@
+#include "Columna.h"
\ No newline at end of file
@@ -0,0 +1,1244 @@
+#ifndef COLUMNA_H
+#define COLUMNA_H
+
+#include "Dato.h"
+#include <cstdint>
+#include <cstdio>
+#include <cstring>
+#include <memory>
+#include <charconv>
+#include <string_view>
+#include <unordered_map>
+#include <iterator>
+#include <ostream>
+#include <functional>
+#include <mutex>
+#include <atomic>
+#include <type_traits>
+
+using namespace std;
+
+// YYYY-MM-DD text of a day count (see ymdToDays)
+inline string formatDateDays(int32_t days)
+{
+    chrono::year_month_day ymd = daysToYmd(days);
+    char buffer[16];
+    snprintf(buffer, sizeof(buffer), "%04d-%02u-%02u",
+             static_cast<int>(ymd.year()),
+             static_cast<unsigned>(ymd.month()),
+             static_cast<unsigned>(ymd.day()));
+    return buffer;
+}
+
+// Hash usable with both string and string_view keys, so dictionary lookups
+// don't need to build a temporary std::string
+struct StringViewHash
+{
+    using is_transparent = void;
+    size_t operator()(string_view sv) const { return hash<string_view>{}(sv); }
+};
+
+// Snapshot I/O (see Snapshot.h): values are written as their in-memory bytes
+// and read back through a bounds-checked cursor, usually over a mapped file
+inline void writeRaw(ostream &out, const void *data, size_t bytes)
+{
+    out.write(static_cast<const char *>(data), static_cast<streamsize>(bytes));
+}
+
+template <typename T>
+inline void writeValue(ostream &out, const T &value)
+{
+    static_assert(is_trivially_copyable_v<T>);
+    writeRaw(out, &value, sizeof(T));
+}
+
+inline void writeString(ostream &out, string_view text)
+{
+    writeValue(out, static_cast<uint32_t>(text.size()));
+    writeRaw(out, text.data(), text.size());
+}
+
+template <typename T>
+inline void writeVector(ostream &out, const vector<T> &values)
+{
+    static_assert(is_trivially_copyable_v<T>);
+    writeValue(out, static_cast<uint64_t>(values.size()));
+    writeRaw(out, values.data(), values.size() * sizeof(T));
+}
+
+// Reads what the write* helpers wrote. Reading past the end yields zeros and
+// empty views and marks the reader as failed, so callers check ok() once.
+class BinaryReader
+{
+private:
+    string_view bytes;
+    size_t position = 0;
+    bool failed = false;
+
+public:
+    explicit BinaryReader(string_view data) : bytes(data) {}
+
+    bool ok() const { return !failed; }
+    size_t getPosition() const { return position; }
+
+    string_view take(size_t n)
+    {
+        if (failed || n > bytes.size() - position)
+        {
+            failed = true;
+            return {};
+        }
+        string_view result = bytes.substr(position, n);
+        position += n;
+        return result;
+    }
+
+    template <typename T>
+    T value()
+    {
+        T result{};
+        string_view raw = take(sizeof(T));
+        if (!failed)
+            memcpy(&result, raw.data(), sizeof(T));
+        return result;
+    }
+
+    string text()
+    {
+        uint32_t length = value<uint32_t>();
+        return string(take(length));
+    }
+
+    template <typename T>
+    void readVector(vector<T> &out)
+    {
+        uint64_t count = value<uint64_t>();
+        if (failed || count > (bytes.size() - position) / sizeof(T))
+        {
+            failed = true;
+            out.clear();
+            return;
+        }
+        out.resize(count);
+        if (count > 0)
+            memcpy(out.data(), take(count * sizeof(T)).data(), count * sizeof(T));
+    }
+};
+
+// Append-only byte storage for the cells of a STRING column. Bytes live in
+// fixed blocks that never move once allocated, so the string_views handed out
+// stay valid for the arena's lifetime, even after the column itself is moved.
+// Each cell is an offset/length pair (offset = block << 32 | position).
+// With interning on, repeated values share one copy of their bytes; it turns
+// itself off when the first values interned turn out to be mostly distinct.
+class StringArena
+{
+public:
+    struct Ref
+    {
+        uint64_t offset;
+        uint32_t length;
+    };
+
+private:
+    static constexpr size_t blockSize = 1 << 16;
+    static constexpr size_t internProbe = 4096;
+
+    vector<unique_ptr<char[]>> blocks;
+    size_t currentBlock = 0;
+    size_t used = blockSize; // bytes used in blocks[currentBlock]; full = none yet
+    vector<Ref> refs;
+    bool interning = false;
+    bool probed = false; // the first internProbe lookups were checked
+    size_t internLookups = 0;
+    size_t internHits = 0;
+    unordered_map<string_view, Ref> internIndex;
+
+    Ref store(string_view value)
+    {
+        if (value.empty())
+            return Ref{0, 0};
+
+        // Values bigger than a quarter block get a block of their own
+        if (value.size() > blockSize / 4)
+        {
+            blocks.push_back(make_unique_for_overwrite<char[]>(value.size()));
+            memcpy(blocks.back().get(), value.data(), value.size());
+            return Ref{static_cast<uint64_t>(blocks.size() - 1) << 32, static_cast<uint32_t>(value.size())};
+        }
+
+        if (used + value.size() > blockSize)
+        {
+            blocks.push_back(make_unique_for_overwrite<char[]>(blockSize));
+            currentBlock = blocks.size() - 1;
+            used = 0;
+        }
+        memcpy(blocks[currentBlock].get() + used, value.data(), value.size());
+        Ref ref{(static_cast<uint64_t>(currentBlock) << 32) | used, static_cast<uint32_t>(value.size())};
+        used += value.size();
+        return ref;
+    }
+
+    Ref intern(string_view value)
+    {
+        internLookups++;
+        auto it = internIndex.find(value);
+        if (it != internIndex.end())
+        {
+            internHits++;
+            return it->second;
+        }
+
+        Ref ref = store(value);
+        internIndex.emplace(view(ref), ref);
+
+        // Mostly distinct so far: the index would cost more than it saves
+        if (!probed && internLookups >= internProbe)
+        {
+            probed = true;
+            if (internHits < internLookups / 4)
+                setInterning(false);
+        }
+        return ref;
+    }
+
+    string_view view(const Ref &ref) const
+    {
+        if (ref.length == 0)
+            return {};
+        return string_view(blocks[ref.offset >> 32].get() + (ref.offset & 0xFFFFFFFFu), ref.length);
+    }
+
+public:
+    StringArena() = default;
+    StringArena(StringArena &&) = default;
+    StringArena &operator=(StringArena &&) = default;
+
+    // Enabling starts a new probe
+    void setInterning(bool enabled)
+    {
+        interning = enabled;
+        if (enabled)
+        {
+            probed = false;
+            internLookups = 0;
+            internHits = 0;
+        }
+        else
+        {
+            unordered_map<string_view, Ref>().swap(internIndex);
+        }
+    }
+    bool isInterning() const { return interning; }
+
+    size_t size() const { return refs.size(); }
+    void reserve(size_t n) { refs.reserve(n); }
+
+    void push_back(string_view value)
+    {
+        refs.push_back(interning ? intern(value) : store(value));
+    }
+
+    string_view operator[](size_t i) const { return view(refs[i]); }
+
+    // Append every cell of 'other', which is left empty. With interning on,
+    // only values not present yet are copied and the rest share this arena's
+    // bytes; otherwise (or once interning turns itself off) the blocks of
+    // 'other' are taken over as they are, without copying.
+    void append(StringArena &&other)
+    {
+        refs.reserve(refs.size() + other.refs.size());
+        size_t next = 0;
+        for (; next < other.refs.size() && interning; ++next)
+            refs.push_back(intern(other.view(other.refs[next])));
+
+        if (next < other.refs.size())
+        {
+            uint64_t blockBase = static_cast<uint64_t>(blocks.size()) << 32;
+            for (auto &block : other.blocks)
+                blocks.push_back(std::move(block));
+            for (; next < other.refs.size(); ++next)
+            {
+                const Ref &ref = other.refs[next];
+                refs.push_back(ref.length == 0 ? ref : Ref{ref.offset + blockBase, ref.length});
+            }
+        }
+        other.clear();
+    }
+
+    // Snapshot image: every cell length, then all the bytes back to back
+    void write(ostream &out) const
+    {
+        vector<uint32_t> lengths(refs.size());
+        uint64_t total = 0;
+        for (size_t i = 0; i < refs.size(); ++i)
+        {
+            lengths[i] = refs[i].length;
+            total += refs[i].length;
+        }
+        writeVector(out, lengths);
+        writeValue(out, total);
+        for (const Ref &ref : refs)
+            writeRaw(out, view(ref).data(), ref.length);
+    }
+
+    bool read(BinaryReader &in)
+    {
+        clear();
+        vector<uint32_t> lengths;
+        in.readVector(lengths);
+        uint64_t total = in.value<uint64_t>();
+        string_view bytes = in.take(total);
+        if (!in.ok())
+            return false;
+
+        refs.reserve(lengths.size());
+        size_t position = 0;
+        for (uint32_t length : lengths)
+        {
+            if (length > bytes.size() - position)
+                return false;
+            refs.push_back(store(bytes.substr(position, length)));
+            position += length;
+        }
+        return true;
+    }
+
+    void clear()
+    {
+        vector<unique_ptr<char[]>>().swap(blocks);
+        vector<Ref>().swap(refs);
+        unordered_map<string_view, Ref>().swap(internIndex);
+        currentBlock = 0;
+        used = blockSize;
+        probed = false;
+        internLookups = 0;
+        internHits = 0;
+    }
+};
+
+// Dictionary codes for a CATEGORY column, stored with the narrowest unsigned
+// type that can hold every code seen so far (uint8 -> uint16 -> uint32). The
+// vector is widened in place the first time a code no longer fits.
+class CategoryCodes
+{
+private:
+    uint8_t width = 1;
+    vector<uint8_t> codes8;
+    vector<uint16_t> codes16;
+    vector<uint32_t> codes32;
+
+    void widenTo(uint8_t newWidth)
+    {
+        if (width == 1 && newWidth >= 2)
+        {
+            codes16.assign(codes8.begin(), codes8.end());
+            codes16.reserve(codes8.capacity());
+            vector<uint8_t>().swap(codes8);
+            width = 2;
+        }
+        if (width == 2 && newWidth == 4)
+        {
+            codes32.assign(codes16.begin(), codes16.end());
+            codes32.reserve(codes16.capacity());
+            vector<uint16_t>().swap(codes16);
+            width = 4;
+        }
+    }
+
+public:
+    // Bytes per code: 1, 2 or 4
+    uint8_t getWidth() const { return width; }
+
+    size_t size() const
+    {
+        return width == 1 ? codes8.size() : width == 2 ? codes16.size()
+                                                       : codes32.size();
+    }
+
+    void reserve(size_t n)
+    {
+        if (width == 1)
+            codes8.reserve(n);
+        else if (width == 2)
+            codes16.reserve(n);
+        else
+            codes32.reserve(n);
+    }
+
+    void push_back(uint32_t code)
+    {
+        if (code > 0xFFFF)
+            widenTo(4);
+        else if (code > 0xFF)
+            widenTo(2);
+
+        if (width == 1)
+            codes8.push_back(static_cast<uint8_t>(code));
+        else if (width == 2)
+            codes16.push_back(static_cast<uint16_t>(code));
+        else
+            codes32.push_back(code);
+    }
+
+    uint32_t operator[](size_t i) const
+    {
+        return width == 1 ? codes8[i] : width == 2 ? codes16[i]
+                                                   : codes32[i];
+    }
+
+    void clear()
+    {
+        vector<uint8_t>().swap(codes8);
+        vector<uint16_t>().swap(codes16);
+        vector<uint32_t>().swap(codes32);
+        width = 1;
+    }
+
+    // Call 'fn' with the underlying vector<uint8_t/uint16_t/uint32_t>
+    template <typename F>
+    void visit(F &&fn) const
+    {
+        if (width == 1)
+            fn(codes8);
+        else if (width == 2)
+            fn(codes16);
+        else
+            fn(codes32);
+    }
+
+    // Snapshot image: the width, then the codes as stored
+    void write(ostream &out) const
+    {
+        writeValue(out, width);
+        visit([&](const auto &values)
+              { writeVector(out, values); });
+    }
+
+    bool read(BinaryReader &in)
+    {
+        clear();
+        width = in.value<uint8_t>();
+        if (width == 1)
+            in.readVector(codes8);
+        else if (width == 2)
+            in.readVector(codes16);
+        else if (width == 4)
+            in.readVector(codes32);
+        else
+            return false;
+        return in.ok();
+    }
+
+    // Dispatch on the width once and run 'fn(row, code)' over every code of
+    // rows [firstRow, lastRow)
+    template <typename F>
+    void forEach(F &&fn, size_t firstRow = 0, size_t lastRow = static_cast<size_t>(-1)) const
+    {
+        if (width == 1)
+            forEachIn(codes8, fn, firstRow, lastRow);
+        else if (width == 2)
+            forEachIn(codes16, fn, firstRow, lastRow);
+        else
+            forEachIn(codes32, fn, firstRow, lastRow);
+    }
+
+private:
+    template <typename T, typename F>
+    static void forEachIn(const vector<T> &values, F &fn, size_t firstRow, size_t lastRow)
+    {
+        size_t end = min(values.size(), lastRow);
+        for (size_t i = firstRow; i < end; ++i)
+            fn(i, static_cast<uint32_t>(values[i]));
+    }
+};
+
+// One typed, contiguous vector per column. Only the vector matching 'type' is used:
+//   INTEGER  -> ints     (int64)
+//   FLOAT    -> floats   (double)
+//   DATE     -> dates    (int32 days since epoch)
+//   CATEGORY -> codes    (uint8/16/32 index into dictionary, see CategoryCodes)
+//   STRING   -> strings  (offset/length pairs into a StringArena)
+// Cells that are empty or fail to parse are null. 'validity' holds one byte per
+// row (0 = null) and stays empty while the column has no nulls.
+class Column
+{
+private:
+    DataType type;
+    vector<uint8_t> validity;
+    size_t nullCount = 0;
+    size_t parseFailures = 0;
+    vector<int64_t> ints;
+    vector<double> floats;
+    vector<int32_t> dates;
+    CategoryCodes codes;
+    vector<string> dictionary;
+    unordered_map<string, uint32_t, StringViewHash, equal_to<>> dictionaryIndex;
+    StringArena strings;
+
+public:
+    explicit Column(DataType t = DataType::STRING) : type(t) {}
+
+    DataType getType() const { return type; }
+
+    size_t size() const
+    {
+        switch (type)
+        {
+        case DataType::INTEGER:
+            return ints.size();
+        case DataType::FLOAT:
+            return floats.size();
+        case DataType::DATE:
+            return dates.size();
+        case DataType::CATEGORY:
+            return codes.size();
+        case DataType::STRING:
+            return strings.size();
+        }
+        return 0;
+    }
+
+    bool isNumeric() const { return type == DataType::INTEGER || type == DataType::FLOAT; }
+
+    void reserve(size_t rows)
+    {
+        switch (type)
+        {
+        case DataType::INTEGER:
+            ints.reserve(rows);
+            break;
+        case DataType::FLOAT:
+            floats.reserve(rows);
+            break;
+        case DataType::DATE:
+            dates.reserve(rows);
+            break;
+        case DataType::CATEGORY:
+            codes.reserve(rows);
+            break;
+        case DataType::STRING:
+            strings.reserve(rows);
+            break;
+        }
+    }
+
+    // Convert a raw CSV cell and append it. Empty or malformed numbers and dates
+    // are stored as nulls (malformed ones are also counted as parse failures).
+    // STRING cells are copied once, into the column's arena.
+    void append(string_view raw)
+    {
+        ParseStatus status = ParseStatus::OK;
+        switch (type)
+        {
+        case DataType::INTEGER:
+        {
+            int64_t value = 0;
+            status = parseNumber(raw, value);
+            ints.push_back(status == ParseStatus::OK ? value : 0);
+            break;
+        }
+        case DataType::FLOAT:
+        {
+            double value = 0.0;
+            status = parseNumber(raw, value);
+            floats.push_back(status == ParseStatus::OK ? value : 0.0);
+            break;
+        }
+        case DataType::DATE:
+        {
+            int32_t days = 0;
+            status = parseDateDays(raw, days);
+            dates.push_back(status == ParseStatus::OK ? days : 0);
+            break;
+        }
+        case DataType::CATEGORY:
+            codes.push_back(internCategory(raw));
+            break;
+        case DataType::STRING:
+            strings.push_back(raw);
+            break;
+        }
+        recordValidity(status);
+    }
+
+    bool isNull(size_t row) const { return !validity.empty() && validity[row] == 0; }
+    bool hasNulls() const { return nullCount > 0; }
+    size_t getNullCount() const { return nullCount; }
+    size_t getParseFailureCount() const { return parseFailures; }
+
+    // Append every cell of 'other' (same type) after the cells of this column.
+    // Category codes are remapped into this column's dictionary; string cells
+    // are appended as StringArena::append does.
+    void appendFrom(Column &&other)
+    {
+        if (!validity.empty() || !other.validity.empty())
+        {
+            validity.resize(size(), 1);
+            if (other.validity.empty())
+                validity.resize(size() + other.size(), 1);
+            else
+                validity.insert(validity.end(), other.validity.begin(), other.validity.end());
+        }
+        nullCount += other.nullCount;
+        parseFailures += other.parseFailures;
+
+        switch (type)
+        {
+        case DataType::INTEGER:
+            ints.insert(ints.end(), other.ints.begin(), other.ints.end());
+            break;
+        case DataType::FLOAT:
+            floats.insert(floats.end(), other.floats.begin(), other.floats.end());
+            break;
+        case DataType::DATE:
+            dates.insert(dates.end(), other.dates.begin(), other.dates.end());
+            break;
+        case DataType::CATEGORY:
+        {
+            vector<uint32_t> remap(other.dictionary.size());
+            for (size_t d = 0; d < other.dictionary.size(); ++d)
+            {
+                remap[d] = internCategory(other.dictionary[d]);
+            }
+            codes.reserve(codes.size() + other.codes.size());
+            other.codes.forEach([&](size_t, uint32_t code)
+                                { codes.push_back(remap[code]); });
+            break;
+        }
+        case DataType::STRING:
+            strings.append(std::move(other.strings));
+            break;
+        }
+    }
+
+    // Snapshot image of the column (see Snapshot.h): type, null counts and
+    // validity bytes, then the typed values, dictionary or string bytes
+    void write(ostream &out) const
+    {
+        writeValue(out, static_cast<uint8_t>(type));
+        writeValue(out, static_cast<uint64_t>(nullCount));
+        writeValue(out, static_cast<uint64_t>(parseFailures));
+        writeVector(out, validity);
+        switch (type)
+        {
+        case DataType::INTEGER:
+            writeVector(out, ints);
+            break;
+        case DataType::FLOAT:
+            writeVector(out, floats);
+            break;
+        case DataType::DATE:
+            writeVector(out, dates);
+            break;
+        case DataType::CATEGORY:
+            codes.write(out);
+            writeValue(out, static_cast<uint64_t>(dictionary.size()));
+            for (const string &value : dictionary)
+                writeString(out, value);
+            break;
+        case DataType::STRING:
+            strings.write(out);
+            break;
+        }
+    }
+
+    // Rebuild the column from write()'s bytes; false if they are truncated or
+    // belong to another type
+    bool read(BinaryReader &in)
+    {
+        clear();
+        if (in.value<uint8_t>() != static_cast<uint8_t>(type))
+            return false;
+        nullCount = in.value<uint64_t>();
+        parseFailures = in.value<uint64_t>();
+        in.readVector(validity);
+        switch (type)
+        {
+        case DataType::INTEGER:
+            in.readVector(ints);
+            break;
+        case DataType::FLOAT:
+            in.readVector(floats);
+            break;
+        case DataType::DATE:
+            in.readVector(dates);
+            break;
+        case DataType::CATEGORY:
+        {
+            if (!codes.read(in))
+                return false;
+            uint64_t entries = in.value<uint64_t>();
+            for (uint64_t d = 0; d < entries && in.ok(); ++d)
+                internCategory(in.text());
+            // Every code must name an entry, and entries must be distinct
+            // (a repeated one would shift the codes after it)
+            if (!in.ok() || dictionary.size() != entries)
+                return false;
+            uint32_t maxCode = 0;
+            codes.visit([&](const auto &values)
+                        {
+                            for (auto code : values)
+                                maxCode = max<uint32_t>(maxCode, code); });
+            if (codes.size() > 0 && maxCode >= dictionary.size())
+                return false;
+            break;
+        }
+        case DataType::STRING:
+            if (!strings.read(in))
+                return false;
+            break;
+        }
+        return in.ok() && (validity.empty() || validity.size() == size());
+    }
+
+    void clear()
+    {
+        validity.clear();
+        nullCount = 0;
+        parseFailures = 0;
+        ints.clear();
+        floats.clear();
+        dates.clear();
+        codes.clear();
+        dictionary.clear();
+        dictionaryIndex.clear();
+        strings.clear();
+    }
+
+    double getNumeric(size_t row) const
+    {
+        if (type == DataType::INTEGER)
+            return static_cast<double>(ints[row]);
+        if (type == DataType::FLOAT)
+            return floats[row];
+        return 0.0;
+    }
+
+    // Dispatch on the column type once and run 'fn' over every non-null value
+    template <typename F>
+    void forEachNumeric(F &&fn) const
+    {
+        if (type == DataType::INTEGER)
+            forEachValid(ints, fn);
+        else if (type == DataType::FLOAT)
+            forEachValid(floats, fn);
+    }
+
+    // Same as above, for rows [firstRow, lastRow) only (e.g. freshly appended
+    // ones, or one range of a column summarized in parallel)
+    template <typename F>
+    void forEachNumericFrom(size_t firstRow, F &&fn, size_t lastRow = static_cast<size_t>(-1)) const
+    {
+        if (type == DataType::INTEGER)
+            forEachValid(ints, fn, firstRow, lastRow);
+        else if (type == DataType::FLOAT)
+            forEachValid(floats, fn, firstRow, lastRow);
+    }
+
+    // Same as above, restricted to the given rows (in the order given)
+    template <typename F>
+    void forEachNumeric(const vector<size_t> &rows, F &&fn) const
+    {
+        if (!isNumeric())
+            return;
+        for (size_t row : rows)
+        {
+            if (!isNull(row))
+                fn(getNumeric(row));
+        }
+    }
+
+    string getAsString(size_t row) const
+    {
+        if (isNull(row))
+            return "";
+
+        switch (type)
+        {
+        case DataType::INTEGER:
+            return to_string(ints[row]);
+        case DataType::FLOAT:
+        {
+            stringstream ss;
+            ss << fixed << setprecision(2) << floats[row];
+            return ss.str();
+        }
+        case DataType::DATE:
+            return formatDateDays(dates[row]);
+        case DataType::CATEGORY:
+            return dictionary[codes[row]];
+        case DataType::STRING:
+            return string(strings[row]);
+        }
+        return "";
+    }
+
+    // Text of a STRING or CATEGORY cell without copying it ("" for other types).
+    // Valid while the column is alive.
+    string_view getView(size_t row) const
+    {
+        if (type == DataType::STRING)
+            return strings[row];
+        if (type == DataType::CATEGORY)
+            return dictionary[codes[row]];
+        return {};
+    }
+
+    // Deduplicate repeated STRING values (see StringArena). Applies to cells
+    // appended from now on.
+    void setStringInterning(bool enabled) { strings.setInterning(enabled); }
+
+    // Legacy variant view of a cell, used when a full Dato has to be materialized
+    DataValue getValue(size_t row) const
+    {
+        if (isNull(row))
+            return monostate{};
+
+        switch (type)
+        {
+        case DataType::INTEGER:
+            return ints[row];
+        case DataType::FLOAT:
+            return static_cast<float>(floats[row]);
+        case DataType::DATE:
+            return daysToYmd(dates[row]);
+        case DataType::CATEGORY:
+            return NamedCategory{dictionary[codes[row]]};
+        case DataType::STRING:
+            return getAsString(row);
+        }
+        return string();
+    }
+
+    // Typed storage accessors for tight scans
+    const vector<int64_t> &getInts() const { return ints; }
+    const vector<double> &getFloats() const { return floats; }
+    const vector<int32_t> &getDates() const { return dates; }
+    const CategoryCodes &getCodes() const { return codes; }
+    const vector<string> &getDictionary() const { return dictionary; }
+
+    // Code of a CATEGORY cell; equal codes mean equal values, so it can be used
+    // directly as a group key
+    uint32_t getCategoryCode(size_t row) const { return codes[row]; }
+
+    static constexpr uint32_t noCode = 0xFFFFFFFFu;
+
+    // Code of 'value' in this column's dictionary, or noCode if it never occurs
+    uint32_t findCategoryCode(string_view value) const
+    {
+        auto it = dictionaryIndex.find(value);
+        return it == dictionaryIndex.end() ? noCode : it->second;
+    }
+
+    // Occurrences of every dictionary entry, indexed by code
+    vector<size_t> countCategories() const
+    {
+        vector<size_t> counts(dictionary.size(), 0);
+        countCategories(counts, 0);
+        return counts;
+    }
+
+    // Add the codes of rows [firstRow, lastRow) to 'counts' (grown to the
+    // dictionary size), so running counts only need the new rows
+    void countCategories(vector<size_t> &counts, size_t firstRow, size_t lastRow = static_cast<size_t>(-1)) const
+    {
+        counts.resize(dictionary.size(), 0);
+        codes.forEach([&](size_t, uint32_t code)
+                      { counts[code]++; },
+                      firstRow, lastRow);
+    }
+
+private:
+    uint32_t internCategory(string_view val)
+    {
+        auto it = dictionaryIndex.find(val);
+        if (it != dictionaryIndex.end())
+            return it->second;
+
+        uint32_t code = static_cast<uint32_t>(dictionary.size());
+        dictionary.emplace_back(val);
+        dictionaryIndex.emplace(string(val), code);
+        return code;
+    }
+
+    template <typename T, typename F>
+    void forEachValid(const vector<T> &values, F &fn, size_t firstRow = 0,
+                      size_t lastRow = static_cast<size_t>(-1)) const
+    {
+        size_t end = min(values.size(), lastRow);
+        if (validity.empty())
+        {
+            for (size_t i = firstRow; i < end; ++i)
+                fn(static_cast<double>(values[i]));
+            return;
+        }
+        for (size_t i = firstRow; i < end; ++i)
+        {
+            if (validity[i])
+                fn(static_cast<double>(values[i]));
+        }
+    }
+
+    // Called once per appended cell, after the value itself was pushed
+    void recordValidity(ParseStatus status)
+    {
+        if (status == ParseStatus::OK)
+        {
+            if (!validity.empty())
+                validity.push_back(1);
+            return;
+        }
+
+        // First null: materialize the validity bytes for the rows before it
+        if (validity.empty())
+            validity.assign(size() - 1, 1);
+        validity.push_back(0);
+        nullCount++;
+        if (status != ParseStatus::EMPTY)
+            parseFailures++;
+    }
+};
+
+class ColumnTable;
+
+// Lightweight proxy for one row of a ColumnTable. Exposes the read side of the
+// Dato API so existing row-oriented callers keep working.
+class RowView
+{
+private:
+    const ColumnTable *table;
+    size_t row;
+
+public:
+    RowView(const ColumnTable *t, size_t r) : table(t), row(r) {}
+
+    size_t getRowIndex() const { return row; }
+    size_t getColumnCount() const;
+    DataValue getValue(size_t columnIndex) const;
+    string getValueAsString(size_t columnIndex) const;
+    string_view getValueView(size_t columnIndex) const;
+    bool isNumericColumn(size_t columnIndex) const;
+    bool isNull(size_t columnIndex) const;
+    double getNumericValue(size_t columnIndex) const;
+    void display() const;
+
+    // Copy the row out into a standalone Dato
+    Dato toDato() const;
+};
+
+class ColumnTable
+{
+private:
+    shared_ptr<const Schema> schema = Schema::empty();
+    vector<Column> columns;
+    size_t rowCount = 0;
+
+    // Columns filled on first access by a loader (snapshots, projected loads),
+    // exactly once even when several threads ask at the same time
+    struct PendingColumns
+    {
+        function<void(size_t, Column &)> loader;
+        vector<char> pending; // fixed once set: which columns the loader fills
+        unique_ptr<once_flag[]> once;
+        unique_ptr<atomic<bool>[]> loaded;
+    };
+    unique_ptr<PendingColumns> lazy;
+
+    // Fill every column still pending; done before the table is modified
+    void materialize()
+    {
+        if (!lazy)
+            return;
+        for (size_t i = 0; i < columns.size(); ++i)
+            getColumn(i);
+        lazy.reset();
+    }
+
+public:
+    class const_iterator
+    {
+    private:
+        const ColumnTable *table;
+        size_t row;
+
+    public:
+        using iterator_category = random_access_iterator_tag;
+        using value_type = RowView;
+        using difference_type = ptrdiff_t;
+        using pointer = void;
+        using reference = RowView;
+
+        const_iterator(const ColumnTable *t, size_t r) : table(t), row(r) {}
+
+        RowView operator*() const { return RowView(table, row); }
+        const_iterator &operator++()
+        {
+            ++row;
+            return *this;
+        }
+        const_iterator operator++(int)
+        {
+            const_iterator copy = *this;
+            ++row;
+            return copy;
+        }
+        const_iterator operator+(difference_type n) const { return const_iterator(table, row + n); }
+        difference_type operator-(const const_iterator &other) const
+        {
+            return static_cast<difference_type>(row) - static_cast<difference_type>(other.row);
+        }
+        bool operator==(const const_iterator &other) const { return row == other.row; }
+        bool operator!=(const const_iterator &other) const { return row != other.row; }
+    };
+
+    ColumnTable() = default;
+
+    // Set the structure (columns and types), dropping any previous rows
+    void setStructure(const vector<string> &names, const vector<DataType> &types)
+    {
+        setSchema(Schema::create(names, types));
+    }
+
+    void setSchema(shared_ptr<const Schema> sharedSchema)
+    {
+        schema = sharedSchema ? std::move(sharedSchema) : Schema::empty();
+        lazy.reset();
+        columns.clear();
+        columns.reserve(schema->getColumnCount());
+        for (DataType type : schema->getColumnTypes())
+        {
+            columns.emplace_back(type);
+        }
+        rowCount = 0;
+    }
+
+    // A table of 'rows' rows whose columns are produced by 'loader(index, column)'
+    // the first time they are read (e.g. from a snapshot, see Snapshot.h)
+    void setLazyColumns(shared_ptr<const Schema> sharedSchema, size_t rows,
+                        function<void(size_t, Column &)> loader)
+    {
+        setSchema(std::move(sharedSchema));
+        rowCount = rows;
+        setColumnLoader(vector<char>(columns.size(), 1), std::move(loader));
+    }
+
+    // Leave the columns flagged in 'pending' (still empty) to 'loader', which
+    // must give them size() rows when they are first read
+    void setColumnLoader(vector<char> pending, function<void(size_t, Column &)> loader)
+    {
+        lazy = make_unique<PendingColumns>();
+        lazy->loader = std::move(loader);
+        lazy->pending = std::move(pending);
+        lazy->pending.resize(columns.size(), 0);
+        lazy->once = make_unique<once_flag[]>(columns.size());
+        lazy->loaded = make_unique<atomic<bool>[]>(columns.size());
+    }
+
+    // Rows appended while some columns are still pending: 'tail(index, column)'
+    // adds the new rows to a pending column right after the current loader
+    // filled it, so the loader keeps giving size() rows
+    void extendColumnLoader(function<void(size_t, Column &)> tail)
+    {
+        if (!lazy)
+            return;
+        lazy->loader = [previous = std::move(lazy->loader), tail = std::move(tail)](size_t index, Column &column)
+        {
+            previous(index, column);
+            tail(index, column);
+        };
+    }
+
+    // False while a pending column has not been read yet
+    bool isColumnLoaded(size_t index) const
+    {
+        return !lazy || index >= columns.size() || !lazy->pending[index] || lazy->loaded[index].load();
+    }
+
+    void reserve(size_t rows)
+    {
+        materialize();
+        for (auto &column : columns)
+            column.reserve(rows);
+    }
+
+    void setStringInterning(bool enabled)
+    {
+        materialize();
+        for (auto &column : columns)
+            column.setStringInterning(enabled);
+    }
+
+    // Append one raw row; 'row' must have one cell per column
+    void appendRow(const vector<string_view> &row)
+    {
+        materialize();
+        for (size_t i = 0; i < columns.size(); ++i)
+        {
+            columns[i].append(row[i]);
+        }
+        rowCount++;
+    }
+
+    // Append one raw row to the listed columns only (a projected load); the
+    // others stay empty until setColumnLoader provides them
+    void appendRow(const vector<string_view> &row, const vector<size_t> &columnsToFill)
+    {
+        for (size_t i : columnsToFill)
+        {
+            columns[i].append(row[i]);
+        }
+        rowCount++;
+    }
+
+    // Append all rows of a table built with the same schema (e.g. one load chunk)
+    void appendTable(ColumnTable &&other)
+    {
+        if (rowCount == 0)
+        {
+            *this = std::move(other);
+            return;
+        }
+        materialize();
+        other.materialize();
+        for (size_t i = 0; i < columns.size(); ++i)
+        {
+            columns[i].appendFrom(std::move(other.columns[i]));
+        }
+        rowCount += other.rowCount;
+        other.clear();
+    }
+
+    // Append the rows of a table built with the same schema, in which only the
+    // columns read so far were filled (e.g. converted with that projection).
+    // Pending columns are left to the loader; see extendColumnLoader.
+    void appendLoadedColumns(ColumnTable &&other)
+    {
+        for (size_t i = 0; i < columns.size(); ++i)
+        {
+            if (isColumnLoaded(i))
+                columns[i].appendFrom(std::move(other.columns[i]));
+        }
+        rowCount += other.rowCount;
+        other.clear();
+    }
+
+    void clear()
+    {
+        schema = Schema::empty();
+        lazy.reset();
+        columns.clear();
+        rowCount = 0;
+    }
+
+    size_t size() const { return rowCount; }
+    bool empty() const { return rowCount == 0; }
+    size_t getColumnCount() const { return columns.size(); }
+
+    const Column &getColumn(size_t index) const
+    {
+        if (lazy && index < columns.size() && lazy->pending[index])
+        {
+            // Only this call_once writes the column, before anyone can read it
+            call_once(lazy->once[index], [&]
+                      {
+                          lazy->loader(index, const_cast<Column &>(columns[index]));
+                          lazy->loaded[index] = true; });
+        }
+        return columns.at(index);
+    }
+    const shared_ptr<const Schema> &getSchema() const { return schema; }
+    const vector<string> &getColumnNames() const { return schema->getColumnNames(); }
+    const vector<DataType> &getColumnTypes() const { return schema->getColumnTypes(); }
+
+    RowView operator[](size_t row) const { return RowView(this, row); }
+    const_iterator begin() const { return const_iterator(this, 0); }
+    const_iterator end() const { return const_iterator(this, rowCount); }
+};
+
+inline size_t RowView::getColumnCount() const
+{
+    return table->getColumnCount();
+}
+
+inline DataValue RowView::getValue(size_t columnIndex) const
+{
+    if (columnIndex >= table->getColumnCount())
+    {
+        throw std::out_of_range("Column index out of range");
+    }
+    return table->getColumn(columnIndex).getValue(row);
+}
+
+inline string RowView::getValueAsString(size_t columnIndex) const
+{
+    if (columnIndex >= table->getColumnCount())
+        return "";
+    return table->getColumn(columnIndex).getAsString(row);
+}
+
+inline bool RowView::isNumericColumn(size_t columnIndex) const
+{
+    if (columnIndex >= table->getColumnCount())
+        return false;
+    return table->getColumn(columnIndex).isNumeric();
+}
+
+inline string_view RowView::getValueView(size_t columnIndex) const
+{
+    if (columnIndex >= table->getColumnCount())
+        return {};
+    return table->getColumn(columnIndex).getView(row);
+}
+
+inline bool RowView::isNull(size_t columnIndex) const
+{
+    if (columnIndex >= table->getColumnCount())
+        return true;
+    return table->getColumn(columnIndex).isNull(row);
+}
+
+inline double RowView::getNumericValue(size_t columnIndex) const
+{
+    if (!isNumericColumn(columnIndex))
+        return 0.0;
+    return table->getColumn(columnIndex).getNumeric(row);
+}
+
+inline void RowView::display() const
+{
+    const auto &names = table->getColumnNames();
+
+    // Print column headers
+    for (size_t i = 0; i < names.size(); ++i)
+    {
+        std::cout << std::setw(15) << names[i];
+    }
+    std::cout << std::endl;
+
+    // Print separator
+    for (size_t i = 0; i < names.size(); ++i)
+    {
+        std::cout << std::setw(15) << "---------------";
+    }
+    std::cout << std::endl;
+
+    // Print values
+    for (size_t i = 0; i < names.size(); ++i)
+    {
+        std::cout << std::setw(15) << getValueAsString(i);
+    }
+    std::cout << std::endl;
+}
+
+inline Dato RowView::toDato() const
+{
+    Dato dato(table->getSchema());
+    for (size_t i = 0; i < table->getColumnCount(); ++i)
+    {
+        dato.setValue(i, getValue(i));
+    }
+    return dato;
+}
+
+#endif // COLUMNA_H
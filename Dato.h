@@ -2,14 +2,19 @@
 #define DATO_H
 
 #include <string>
+#include <cstdint>
 #include <variant>
 #include <vector>
 #include <map>
+#include <memory>
+#include <unordered_map>
 #include <chrono>
 #include <iostream>
 #include <sstream>
 #include <algorithm>
 #include <iomanip>
+#include <charconv>
+#include <string_view>
 
 using namespace std;
 
@@ -31,102 +36,277 @@ struct NamedCategory
     bool operator<(const NamedCategory &other) const { return value < other.value; }
 };
 
-using DataValue = variant<int, float, string, chrono::year_month_day, NamedCategory>;
+// monostate marks a null cell (empty or unparseable input). INTEGER cells are
+// 64-bit, like the column storage, so no value is cut down on the way.
+using DataValue = variant<monostate, int64_t, float, string, chrono::year_month_day, NamedCategory>;
 
-class Dato
+// Result of converting one text cell. Conversions never throw.
+enum class ParseStatus
+{
+    OK,
+    EMPTY,
+    INVALID,
+    OUT_OF_RANGE
+};
+
+// Parse a whole cell as a number with std::from_chars. Trailing garbage is INVALID.
+template <typename T>
+inline ParseStatus parseNumber(string_view text, T &out)
+{
+    if (text.empty())
+        return ParseStatus::EMPTY;
+
+    const char *first = text.data();
+    const char *last = first + text.size();
+    // from_chars does not accept a leading '+'
+    if (*first == '+' && last - first > 1 && first[1] != '-')
+        ++first;
+
+    auto [ptr, ec] = from_chars(first, last, out);
+    if (ec == errc::result_out_of_range)
+        return ParseStatus::OUT_OF_RANGE;
+    if (ec != errc() || ptr != last)
+        return ParseStatus::INVALID;
+    return ParseStatus::OK;
+}
+
+// Dates are stored as days since 1970-01-01 so columns stay plain integers
+inline int32_t ymdToDays(const chrono::year_month_day &ymd)
+{
+    return static_cast<int32_t>(chrono::sys_days(ymd).time_since_epoch().count());
+}
+
+inline chrono::year_month_day daysToYmd(int32_t days)
+{
+    return chrono::year_month_day(chrono::sys_days(chrono::days(days)));
+}
+
+// Days since 1970-01-01 of a proleptic Gregorian date, computed arithmetically
+// (no calendar validation here)
+inline int32_t daysFromCivil(int year, unsigned month, unsigned day)
+{
+    year -= month <= 2;
+    const int era = (year >= 0 ? year : year - 399) / 400;
+    const unsigned yearOfEra = static_cast<unsigned>(year - era * 400);
+    const unsigned dayOfYear = (153 * (month > 2 ? month - 3 : month + 9) + 2) / 5 + day - 1;
+    const unsigned dayOfEra = yearOfEra * 365 + yearOfEra / 4 - yearOfEra / 100 + dayOfYear;
+    return era * 146097 + static_cast<int>(dayOfEra) - 719468;
+}
+
+inline bool isDateSeparator(char c)
+{
+    return c == '-' || c == '/' || c == '.';
+}
+
+// Slow path for dates that are not fixed-width, e.g. 2023-1-5
+inline ParseStatus parseDateLoose(string_view text, int32_t &days)
+{
+    int parts[3];
+    size_t start = 0;
+    for (int i = 0; i < 3; ++i)
+    {
+        size_t end = text.size();
+        if (i < 2)
+        {
+            end = start;
+            while (end < text.size() && !isDateSeparator(text[end]))
+                ++end;
+            if (end == text.size())
+                return ParseStatus::INVALID;
+        }
+        ParseStatus status = parseNumber(text.substr(start, end - start), parts[i]);
+        if (status != ParseStatus::OK)
+            return status == ParseStatus::EMPTY ? ParseStatus::INVALID : status;
+        start = end + 1;
+    }
+
+    chrono::year_month_day ymd{chrono::year(parts[0]),
+                               chrono::month(static_cast<unsigned>(parts[1])),
+                               chrono::day(static_cast<unsigned>(parts[2]))};
+    if (!ymd.ok())
+        return ParseStatus::INVALID;
+    days = ymdToDays(ymd);
+    return ParseStatus::OK;
+}
+
+// Parse a date into days since epoch. Fixed-width layouts, with '-', '/' or '.'
+// as separator, take a branch-light path:
+//   YYYY-MM-DD (year first)    DD-MM-YYYY (day first)
+// Anything else is read as year-month-day with unpadded fields.
+// The date must exist in the calendar.
+inline ParseStatus parseDateDays(string_view text, int32_t &days)
+{
+    if (text.empty())
+        return ParseStatus::EMPTY;
+    if (text.size() != 10)
+        return parseDateLoose(text, days);
+
+    const char *p = text.data();
+    bool yearFirst = isDateSeparator(p[4]) && p[7] == p[4];
+    bool dayFirst = isDateSeparator(p[2]) && p[5] == p[2];
+    if (!yearFirst && !dayFirst)
+        return ParseStatus::INVALID;
+
+    const char *y = yearFirst ? p : p + 6;
+    const char *m = yearFirst ? p + 5 : p + 3;
+    const char *d = yearFirst ? p + 8 : p;
+    unsigned digit[8] = {
+        static_cast<unsigned>(y[0] - '0'), static_cast<unsigned>(y[1] - '0'),
+        static_cast<unsigned>(y[2] - '0'), static_cast<unsigned>(y[3] - '0'),
+        static_cast<unsigned>(m[0] - '0'), static_cast<unsigned>(m[1] - '0'),
+        static_cast<unsigned>(d[0] - '0'), static_cast<unsigned>(d[1] - '0')};
+    // Any non-digit wraps around to a large unsigned value
+    bool invalid = false;
+    for (unsigned v : digit)
+        invalid |= v > 9;
+    if (invalid)
+        return ParseStatus::INVALID;
+
+    int year = static_cast<int>(digit[0] * 1000 + digit[1] * 100 + digit[2] * 10 + digit[3]);
+    unsigned month = digit[4] * 10 + digit[5];
+    unsigned day = digit[6] * 10 + digit[7];
+
+    static constexpr unsigned char monthDays[12] = {31, 28, 31, 30, 31, 30, 31, 31, 30, 31, 30, 31};
+    bool leap = (year % 4 == 0 && year % 100 != 0) || year % 400 == 0;
+    if (month - 1 >= 12 || day - 1 >= monthDays[month - 1] + unsigned(month == 2 && leap))
+        return ParseStatus::INVALID;
+
+    days = daysFromCivil(year, month, day);
+    return ParseStatus::OK;
+}
+
+// Same as parseDateDays, for callers that want a calendar date
+inline ParseStatus parseDateValue(string_view text, chrono::year_month_day &out)
+{
+    int32_t days = 0;
+    ParseStatus status = parseDateDays(text, days);
+    if (status == ParseStatus::OK)
+        out = daysToYmd(days);
+    return status;
+}
+
+// Column names and types of a dataset. Immutable once built, so every row of
+// the dataset can share one instance through a shared_ptr.
+class Schema
 {
 private:
     vector<string> columnNames;
     vector<DataType> columnTypes;
-    vector<DataValue> values;
+    unordered_map<string, size_t> nameIndex;
 
 public:
-    Dato() = default;
+    static constexpr size_t npos = static_cast<size_t>(-1);
 
-    Dato(const vector<string> &names, const vector<DataType> &types)
+    Schema() = default;
+
+    Schema(const vector<string> &names, const vector<DataType> &types)
         : columnNames(names), columnTypes(types)
     {
-        values.resize(names.size());
+        if (names.size() != types.size())
+        {
+            throw std::invalid_argument("Column names and types must have the same size");
+        }
+        nameIndex.reserve(names.size());
+        for (size_t i = 0; i < names.size(); ++i)
+        {
+            // emplace keeps the first occurrence, like a linear find would
+            nameIndex.emplace(names[i], i);
+        }
     }
 
-    Dato(const Dato &other)
-        : columnNames(other.columnNames),
-          columnTypes(other.columnTypes),
-          values(other.values) {}
+    static shared_ptr<const Schema> create(const vector<string> &names, const vector<DataType> &types)
+    {
+        return make_shared<const Schema>(names, types);
+    }
 
-    void setValue(size_t index, const string &val)
+    static const shared_ptr<const Schema> &empty()
     {
-        if (index >= values.size())
-            return;
+        static const shared_ptr<const Schema> emptySchema = make_shared<const Schema>();
+        return emptySchema;
+    }
 
-        try
-        {
-            switch (columnTypes[index])
-            {
-            case DataType::INTEGER:
-                values[index] = stoi(val);
-                break;
-            case DataType::FLOAT:
-                values[index] = stof(val);
-                break;
-            case DataType::STRING:
-                values[index] = val;
-                break;
-            case DataType::DATE:
-                values[index] = parseDate(val);
-                break;
-            case DataType::CATEGORY:
-                values[index] = parseCategory(val);
-                break;
-            }
-        }
-        catch (...)
-        {
-            // Handle conversion errors (defaults)
-            if (columnTypes[index] == DataType::INTEGER)
-                values[index] = 0;
-            else if (columnTypes[index] == DataType::FLOAT)
-                values[index] = 0.0f;
-            else if (columnTypes[index] == DataType::STRING)
-                values[index] = "";
-            else if (columnTypes[index] == DataType::CATEGORY)
-                values[index] = NamedCategory{"Unknown"};
-        }
+    // Index of a column by name, or Schema::npos
+    size_t indexOf(const string &columnName) const
+    {
+        auto it = nameIndex.find(columnName);
+        return it == nameIndex.end() ? npos : it->second;
     }
 
-    Dato &operator=(const Dato &other)
+    const vector<string> &getColumnNames() const { return columnNames; }
+    const vector<DataType> &getColumnTypes() const { return columnTypes; }
+    size_t getColumnCount() const { return columnNames.size(); }
+    DataType getColumnType(size_t index) const { return columnTypes.at(index); }
+};
+
+class Dato
+{
+private:
+    shared_ptr<const Schema> schema = Schema::empty();
+    vector<DataValue> values;
+
+    size_t requireIndex(const string &columnName) const
     {
-        if (this != &other)
+        size_t index = schema->indexOf(columnName);
+        if (index == Schema::npos)
         {
-            columnNames = other.columnNames;
-            columnTypes = other.columnTypes;
-            values = other.values;
+            throw std::invalid_argument("Column name not found: " + columnName);
         }
-        return *this;
+        return index;
+    }
+
+public:
+    Dato() = default;
+
+    // Rows of the same dataset should share one schema instead of copying it
+    explicit Dato(shared_ptr<const Schema> sharedSchema)
+        : schema(sharedSchema ? std::move(sharedSchema) : Schema::empty())
+    {
+        values.resize(schema->getColumnCount());
     }
 
+    Dato(const vector<string> &names, const vector<DataType> &types)
+        : Dato(Schema::create(names, types)) {}
+
+    Dato(const Dato &other) = default;
+    Dato(Dato &&other) noexcept = default;
+
+    // Convert 'val' to the column type; cells that can't be converted become null
+    void setValue(size_t index, const string &val)
+    {
+        if (index >= values.size())
+            return;
+        setValueFromString(index, val);
+    }
+
+    Dato &operator=(const Dato &other) = default;
+    Dato &operator=(Dato &&other) noexcept = default;
+
     // Method to set the structure (columns and types)
     void setStructure(const vector<string> &names, const vector<DataType> &types)
     {
-        if (names.size() != types.size())
-        {
-            throw std::invalid_argument("Column names and types must have the same size");
-        }
-        columnNames = names;
-        columnTypes = types;
-        values.resize(names.size());
+        setSchema(Schema::create(names, types));
     }
 
+    void setSchema(shared_ptr<const Schema> sharedSchema)
+    {
+        schema = sharedSchema ? std::move(sharedSchema) : Schema::empty();
+        values.resize(schema->getColumnCount());
+    }
+
+    // Adding a column detaches this row from the shared schema
     void addColumn(const string &name, DataType type)
     {
-        columnNames.push_back(name);
-        columnTypes.push_back(type);
+        vector<string> names = schema->getColumnNames();
+        vector<DataType> types = schema->getColumnTypes();
+        names.push_back(name);
+        types.push_back(type);
+        schema = Schema::create(names, types);
         values.emplace_back();
     }
 
     void setValue(size_t columnIndex, const DataValue &value)
     {
-        if (columnIndex < 0 || columnIndex >= values.size())
+        if (columnIndex >= values.size())
         {
             throw std::out_of_range("Column index out of range");
         }
@@ -135,13 +315,7 @@ public:
 
     void setValue(const string &columnName, const DataValue &value)
     {
-        auto it = find(columnNames.begin(), columnNames.end(), columnName);
-        if (it == columnNames.end())
-        {
-            throw std::invalid_argument("Column name not found: " + columnName);
-        }
-        size_t index = distance(columnNames.begin(), it);
-        setValue(index, value);
+        setValue(requireIndex(columnName), value);
     }
 
     DataValue getValue(size_t columnIndex) const
@@ -155,13 +329,7 @@ public:
 
     DataValue getValue(const std::string &columnName) const
     {
-        auto it = find(columnNames.begin(), columnNames.end(), columnName);
-        if (it == columnNames.end())
-        {
-            throw std::invalid_argument("Column name not found: " + columnName);
-        }
-        size_t index = distance(columnNames.begin(), it);
-        return getValue(index);
+        return getValue(requireIndex(columnName));
     }
 
     // Method to get value as string for display
@@ -173,7 +341,7 @@ public:
         return visit([this, index](auto &&arg) -> string
                      {
             using T = decay_t<decltype(arg)>;
-            if constexpr (is_same_v<T, int>)
+            if constexpr (is_same_v<T, int64_t>)
                 return to_string(arg);
             else if constexpr (is_same_v<T, float>) {
                 stringstream ss;
@@ -192,62 +360,80 @@ public:
             return ""; }, values[index]);
     }
 
-    void setValueFromString(size_t columnIndex, const string &strValue)
+    // Returns the conversion status instead of throwing; on failure the cell is null
+    ParseStatus setValueFromString(size_t columnIndex, string_view strValue)
     {
-        if (columnIndex >= columnTypes.size())
+        if (columnIndex >= schema->getColumnCount())
         {
             throw std::out_of_range("Column index out of range");
         }
 
-        switch (columnTypes[columnIndex])
+        ParseStatus status = ParseStatus::OK;
+        switch (schema->getColumnType(columnIndex))
         {
         case DataType::INTEGER:
-            setValue(columnIndex, std::stoi(strValue));
+        {
+            // Same range as the INTEGER column storage
+            int64_t number = 0;
+            status = parseNumber(strValue, number);
+            if (status == ParseStatus::OK)
+                values[columnIndex] = number;
             break;
+        }
         case DataType::FLOAT:
-            setValue(columnIndex, std::stof(strValue));
+        {
+            float number = 0.0f;
+            status = parseNumber(strValue, number);
+            if (status == ParseStatus::OK)
+                values[columnIndex] = number;
             break;
+        }
         case DataType::STRING:
-            setValue(columnIndex, strValue);
+            values[columnIndex] = string(strValue);
             break;
         case DataType::DATE:
-            setValue(columnIndex, parseDate(strValue));
+        {
+            chrono::year_month_day date;
+            status = parseDateValue(strValue, date);
+            if (status == ParseStatus::OK)
+                values[columnIndex] = date;
             break;
+        }
         case DataType::CATEGORY:
-            setValue(columnIndex, parseCategory(strValue));
+            values[columnIndex] = parseCategory(strValue);
             break;
         }
+
+        if (status != ParseStatus::OK)
+            values[columnIndex] = monostate{};
+        return status;
     }
 
-    void setValueFromString(const string &columnName, const std::string &strValue)
+    ParseStatus setValueFromString(const string &columnName, const std::string &strValue)
     {
-        auto it = find(columnNames.begin(), columnNames.end(), columnName);
-        if (it == columnNames.end())
-        {
-            throw std::invalid_argument("Column name not found: " + columnName);
-        }
-        size_t index = distance(columnNames.begin(), it);
-        setValueFromString(index, strValue);
+        return setValueFromString(requireIndex(columnName), strValue);
+    }
+
+    bool isNull(size_t columnIndex) const
+    {
+        return columnIndex >= values.size() || holds_alternative<monostate>(values[columnIndex]);
     }
 
     // The Getters
-    const vector<std::string> &getColumnNames() const { return columnNames; }
-    const vector<DataType> &getColumnTypes() const { return columnTypes; }
-    size_t getColumnCount() const { return columnNames.size(); }
+    const shared_ptr<const Schema> &getSchema() const { return schema; }
+    const vector<std::string> &getColumnNames() const { return schema->getColumnNames(); }
+    const vector<DataType> &getColumnTypes() const { return schema->getColumnTypes(); }
+    size_t getColumnCount() const { return schema->getColumnCount(); }
 
     DataType getColumnType(const string &columnName) const
     {
-        auto it = std::find(columnNames.begin(), columnNames.end(), columnName);
-        if (it == columnNames.end())
-        {
-            throw std::invalid_argument("Column name not found: " + columnName);
-        }
-        size_t index = distance(columnNames.begin(), it);
-        return columnTypes[index];
+        return schema->getColumnType(requireIndex(columnName));
     }
 
     void display() const
     {
+        const vector<string> &columnNames = schema->getColumnNames();
+
         // Print column headers
         for (size_t i = 0; i < columnNames.size(); ++i)
         {
@@ -272,18 +458,17 @@ public:
 
     bool isNumericColumn(size_t columnIndex) const
     {
-        if (columnIndex >= columnTypes.size())
+        if (columnIndex >= schema->getColumnCount())
             return false;
-        return columnTypes[columnIndex] == DataType::INTEGER ||
-               columnTypes[columnIndex] == DataType::FLOAT;
+        DataType type = schema->getColumnType(columnIndex);
+        return type == DataType::INTEGER || type == DataType::FLOAT;
     }
 
     bool isNumericColumn(const string &columnName) const
     {
-        auto it = std::find(columnNames.begin(), columnNames.end(), columnName);
-        if (it == columnNames.end())
+        size_t index = schema->indexOf(columnName);
+        if (index == Schema::npos)
             return false;
-        size_t index = distance(columnNames.begin(), it);
         return isNumericColumn(index);
     }
 
@@ -295,7 +480,7 @@ public:
         return visit([](const auto &value) -> double
                      {
             using T = decay_t<decltype(value)>;
-            if constexpr (std::is_same_v<T, int>) {
+            if constexpr (std::is_same_v<T, int64_t>) {
                 return static_cast<double>(value);
             } else if constexpr (std::is_same_v<T, float>) {
                 return static_cast<double>(value);
@@ -304,35 +489,11 @@ public:
     }
 
 private:
-    std::chrono::year_month_day parseDate(const std::string &dateStr)
-    {
-        // Simple date parsing - assumes YYYY-MM-DD format
-        std::istringstream ss(dateStr);
-        std::string item;
-        std::vector<int> parts;
-
-        while (std::getline(ss, item, '-'))
-        {
-            parts.push_back(std::stoi(item));
-        }
-
-        if (parts.size() == 3)
-        {
-            return std::chrono::year_month_day(
-                std::chrono::year(parts[0]),
-                std::chrono::month(parts[1]),
-                std::chrono::day(parts[2]));
-        }
-
-        // Default date if parsing fails
-        return std::chrono::year_month_day(std::chrono::year(1900), std::chrono::month(1), std::chrono::day(1));
-    }
-
-    NamedCategory parseCategory(const string &val)
+    NamedCategory parseCategory(string_view val)
     {
         // You can still add validation logic here if you want to restrict categories,
         // but for "Custom" names, we just accept the value.
-        return NamedCategory{val};
+        return NamedCategory{string(val)};
     }
 
     // Helper method to convert category to string
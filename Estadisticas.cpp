@@ -0,0 +1 @@
+#include "Estadisticas.h"
@@ -0,0 +1,1612 @@
+#ifndef ESTADISTICAS_H
+#define ESTADISTICAS_H
+
+#include "Columna.h"
+#include <cmath>
+#include <limits>
+#include <algorithm>
+#include <cstring>
+
+using namespace std;
+
+// Count, sum, min, max and variance of a set of values. Two summaries combine
+// with the pairwise (Chan et al.) update of Welford's moments, so blocks and
+// threads can be summarized separately and merged without losing precision.
+struct NumericSummary
+{
+    size_t count = 0;
+    double sum = 0.0;
+    double mean = 0.0;
+    double m2 = 0.0; // sum of squared deviations from the mean
+    double min = numeric_limits<double>::infinity();
+    double max = -numeric_limits<double>::infinity();
+
+    void add(double v)
+    {
+        count++;
+        sum += v;
+        double delta = v - mean;
+        mean += delta / count;
+        m2 += delta * (v - mean);
+        min = std::min(min, v);
+        max = std::max(max, v);
+    }
+
+    void merge(const NumericSummary &other)
+    {
+        if (other.count == 0)
+            return;
+        if (count == 0)
+        {
+            *this = other;
+            return;
+        }
+        size_t total = count + other.count;
+        double delta = other.mean - mean;
+        mean += delta * other.count / total;
+        m2 += other.m2 + delta * delta * (static_cast<double>(count) * other.count / total);
+        sum += other.sum;
+        count = total;
+        min = std::min(min, other.min);
+        max = std::max(max, other.max);
+    }
+
+    bool empty() const { return count == 0; }
+    // Population variance, as printed by the reports
+    double variance() const { return count ? m2 / count : 0.0; }
+    double stddev() const { return std::sqrt(variance()); }
+};
+
+enum class StatsKernel
+{
+    SCALAR,
+    AVX2,
+    AVX512
+};
+
+// Values are summarized in blocks small enough to stay in L1: one pass for
+// sum/min/max, a second over the cached block for the squared deviations from
+// the block mean, then the block is merged into the running summary.
+constexpr size_t statsBlockSize = 2048;
+
+inline NumericSummary blockSummary(size_t n, double sum, double minVal, double maxVal, double m2)
+{
+    NumericSummary block;
+    block.count = n;
+    block.sum = sum;
+    block.mean = sum / n;
+    block.m2 = m2;
+    block.min = minVal;
+    block.max = maxVal;
+    return block;
+}
+
+inline NumericSummary summarizeBlockScalar(const double *values, size_t n)
+{
+    if (n == 0)
+        return NumericSummary();
+
+    double sum = 0.0;
+    double minVal = values[0];
+    double maxVal = values[0];
+    for (size_t i = 0; i < n; ++i)
+    {
+        sum += values[i];
+        minVal = values[i] < minVal ? values[i] : minVal;
+        maxVal = values[i] > maxVal ? values[i] : maxVal;
+    }
+
+    double mean = sum / n;
+    double m2 = 0.0;
+    for (size_t i = 0; i < n; ++i)
+    {
+        double d = values[i] - mean;
+        m2 += d * d;
+    }
+    return blockSummary(n, sum, minVal, maxVal, m2);
+}
+
+#if defined(__x86_64__) || defined(_M_X64)
+#if defined(__GNUC__) || defined(__clang__)
+#define ESTADISTICAS_SIMD 1
+#include <immintrin.h>
+
+__attribute__((target("avx2"))) inline double horizontalSum256(__m256d v)
+{
+    __m128d low = _mm256_castpd256_pd128(v);
+    __m128d high = _mm256_extractf128_pd(v, 1);
+    low = _mm_add_pd(low, high);
+    return _mm_cvtsd_f64(_mm_add_sd(low, _mm_unpackhi_pd(low, low)));
+}
+
+__attribute__((target("avx2"))) inline NumericSummary summarizeBlockAVX2(const double *values, size_t n)
+{
+    if (n < 8)
+        return summarizeBlockScalar(values, n);
+
+    // Two independent accumulators per quantity to hide the add latency
+    __m256d sum0 = _mm256_setzero_pd();
+    __m256d sum1 = _mm256_setzero_pd();
+    __m256d min0 = _mm256_set1_pd(values[0]);
+    __m256d min1 = min0;
+    __m256d max0 = min0;
+    __m256d max1 = min0;
+    size_t i = 0;
+    for (; i + 8 <= n; i += 8)
+    {
+        __m256d a = _mm256_loadu_pd(values + i);
+        __m256d b = _mm256_loadu_pd(values + i + 4);
+        sum0 = _mm256_add_pd(sum0, a);
+        sum1 = _mm256_add_pd(sum1, b);
+        min0 = _mm256_min_pd(min0, a);
+        min1 = _mm256_min_pd(min1, b);
+        max0 = _mm256_max_pd(max0, a);
+        max1 = _mm256_max_pd(max1, b);
+    }
+
+    double sum = horizontalSum256(_mm256_add_pd(sum0, sum1));
+    alignas(32) double lanes[4];
+    _mm256_store_pd(lanes, _mm256_min_pd(min0, min1));
+    double minVal = std::min(std::min(lanes[0], lanes[1]), std::min(lanes[2], lanes[3]));
+    _mm256_store_pd(lanes, _mm256_max_pd(max0, max1));
+    double maxVal = std::max(std::max(lanes[0], lanes[1]), std::max(lanes[2], lanes[3]));
+    for (; i < n; ++i)
+    {
+        sum += values[i];
+        minVal = std::min(minVal, values[i]);
+        maxVal = std::max(maxVal, values[i]);
+    }
+
+    double mean = sum / n;
+    __m256d meanVec = _mm256_set1_pd(mean);
+    __m256d m20 = _mm256_setzero_pd();
+    __m256d m21 = _mm256_setzero_pd();
+    for (i = 0; i + 8 <= n; i += 8)
+    {
+        __m256d a = _mm256_sub_pd(_mm256_loadu_pd(values + i), meanVec);
+        __m256d b = _mm256_sub_pd(_mm256_loadu_pd(values + i + 4), meanVec);
+        m20 = _mm256_add_pd(m20, _mm256_mul_pd(a, a));
+        m21 = _mm256_add_pd(m21, _mm256_mul_pd(b, b));
+    }
+    double m2 = horizontalSum256(_mm256_add_pd(m20, m21));
+    for (; i < n; ++i)
+    {
+        double d = values[i] - mean;
+        m2 += d * d;
+    }
+    return blockSummary(n, sum, minVal, maxVal, m2);
+}
+
+// GCC 12's AVX-512 headers trigger a false -Wmaybe-uninitialized (GCC bug 105593)
+#pragma GCC diagnostic push
+#pragma GCC diagnostic ignored "-Wmaybe-uninitialized"
+__attribute__((target("avx512f"))) inline NumericSummary summarizeBlockAVX512(const double *values, size_t n)
+{
+    if (n < 8)
+        return summarizeBlockScalar(values, n);
+
+    __m512d sumVec = _mm512_setzero_pd();
+    __m512d minVec = _mm512_set1_pd(values[0]);
+    __m512d maxVec = minVec;
+    size_t i = 0;
+    for (; i + 8 <= n; i += 8)
+    {
+        __m512d a = _mm512_loadu_pd(values + i);
+        sumVec = _mm512_add_pd(sumVec, a);
+        minVec = _mm512_min_pd(minVec, a);
+        maxVec = _mm512_max_pd(maxVec, a);
+    }
+
+    double sum = horizontalSum256(_mm256_add_pd(_mm512_castpd512_pd256(sumVec), _mm512_extractf64x4_pd(sumVec, 1)));
+    alignas(64) double lanes[8];
+    _mm512_store_pd(lanes, minVec);
+    double minVal = *std::min_element(lanes, lanes + 8);
+    _mm512_store_pd(lanes, maxVec);
+    double maxVal = *std::max_element(lanes, lanes + 8);
+    for (; i < n; ++i)
+    {
+        sum += values[i];
+        minVal = std::min(minVal, values[i]);
+        maxVal = std::max(maxVal, values[i]);
+    }
+
+    double mean = sum / n;
+    __m512d meanVec = _mm512_set1_pd(mean);
+    __m512d m2Vec = _mm512_setzero_pd();
+    for (i = 0; i + 8 <= n; i += 8)
+    {
+        __m512d d = _mm512_sub_pd(_mm512_loadu_pd(values + i), meanVec);
+        m2Vec = _mm512_fmadd_pd(d, d, m2Vec);
+    }
+    double m2 = horizontalSum256(_mm256_add_pd(_mm512_castpd512_pd256(m2Vec), _mm512_extractf64x4_pd(m2Vec, 1)));
+    for (; i < n; ++i)
+    {
+        double d = values[i] - mean;
+        m2 += d * d;
+    }
+    return blockSummary(n, sum, minVal, maxVal, m2);
+}
+#pragma GCC diagnostic pop
+#endif
+#endif
+
+inline bool isStatsKernelSupported(StatsKernel kernel)
+{
+    switch (kernel)
+    {
+    case StatsKernel::SCALAR:
+        return true;
+    case StatsKernel::AVX2:
+#ifdef ESTADISTICAS_SIMD
+        return __builtin_cpu_supports("avx2");
+#else
+        return false;
+#endif
+    case StatsKernel::AVX512:
+#ifdef ESTADISTICAS_SIMD
+        return __builtin_cpu_supports("avx512f");
+#else
+        return false;
+#endif
+    }
+    return false;
+}
+
+// Kernel in use; picks the widest supported one the first time it is called
+inline StatsKernel &activeStatsKernel()
+{
+    static StatsKernel kernel = isStatsKernelSupported(StatsKernel::AVX512) ? StatsKernel::AVX512
+                                : isStatsKernelSupported(StatsKernel::AVX2) ? StatsKernel::AVX2
+                                                                            : StatsKernel::SCALAR;
+    return kernel;
+}
+
+// Force a specific kernel (e.g. SCALAR for testing); unsupported kernels are ignored
+inline bool setStatsKernel(StatsKernel kernel)
+{
+    if (!isStatsKernelSupported(kernel))
+        return false;
+    activeStatsKernel() = kernel;
+    return true;
+}
+
+inline const char *statsKernelName(StatsKernel kernel)
+{
+    switch (kernel)
+    {
+    case StatsKernel::SCALAR:
+        return "scalar";
+    case StatsKernel::AVX2:
+        return "AVX2";
+    case StatsKernel::AVX512:
+        return "AVX-512";
+    }
+    return "unknown";
+}
+
+using SummarizeBlockFn = NumericSummary (*)(const double *, size_t);
+
+inline SummarizeBlockFn summarizeBlockFunction(StatsKernel kernel)
+{
+    switch (kernel)
+    {
+#ifdef ESTADISTICAS_SIMD
+    case StatsKernel::AVX512:
+        return summarizeBlockAVX512;
+    case StatsKernel::AVX2:
+        return summarizeBlockAVX2;
+#endif
+    default:
+        return summarizeBlockScalar;
+    }
+}
+
+// Summary of a contiguous run of doubles
+inline NumericSummary summarizeValues(const double *values, size_t n)
+{
+    SummarizeBlockFn kernel = summarizeBlockFunction(activeStatsKernel());
+    NumericSummary summary;
+    for (size_t start = 0; start < n; start += statsBlockSize)
+    {
+        summary.merge(kernel(values + start, std::min(statsBlockSize, n - start)));
+    }
+    return summary;
+}
+
+// Summary of the non-null values of a numeric column, optionally restricted to
+// 'rows'. Null-free FLOAT columns are read in place; everything else is staged
+// through an L1-sized buffer of doubles one block at a time.
+inline NumericSummary summarizeColumn(const Column &column, const vector<size_t> *rows = nullptr)
+{
+    NumericSummary summary;
+    if (!column.isNumeric())
+        return summary;
+
+    if (!rows && !column.hasNulls() && column.getType() == DataType::FLOAT)
+        return summarizeValues(column.getFloats().data(), column.size());
+
+    SummarizeBlockFn kernel = summarizeBlockFunction(activeStatsKernel());
+    double buffer[statsBlockSize];
+    size_t filled = 0;
+    auto push = [&](double v)
+    {
+        buffer[filled++] = v;
+        if (filled == statsBlockSize)
+        {
+            summary.merge(kernel(buffer, filled));
+            filled = 0;
+        }
+    };
+
+    if (rows)
+        column.forEachNumeric(*rows, push);
+    else
+        column.forEachNumeric(push);
+    summary.merge(kernel(buffer, filled));
+    return summary;
+}
+
+// Place the order statistics for every rank in [rankFirst, rankLast) (sorted,
+// distinct, relative to 'offset') at their sorted positions in [first, last).
+// nth_element splits on the middle rank and each side only recurses with the
+// ranks that fall in it, so k ranks cost O(n log k) expected, not a full sort.
+inline void selectRanks(double *first, double *last, const size_t *rankFirst, const size_t *rankLast, size_t offset)
+{
+    if (rankFirst == rankLast || last - first <= 1)
+        return;
+    const size_t *middle = rankFirst + (rankLast - rankFirst) / 2;
+    double *nth = first + (*middle - offset);
+    nth_element(first, nth, last);
+    selectRanks(first, nth, rankFirst, middle, offset);
+    selectRanks(nth + 1, last, middle + 1, rankLast, offset + static_cast<size_t>(nth + 1 - first));
+}
+
+// The k-th smallest value (0-based) for every k in 'ranks'. 'values' is
+// reordered in place; ranks must be < values.size().
+inline vector<double> orderStatistics(vector<double> &values, const vector<size_t> &ranks)
+{
+    vector<size_t> sorted(ranks);
+    sort(sorted.begin(), sorted.end());
+    sorted.erase(unique(sorted.begin(), sorted.end()), sorted.end());
+    selectRanks(values.data(), values.data() + values.size(), sorted.data(), sorted.data() + sorted.size(), 0);
+
+    vector<double> result;
+    result.reserve(ranks.size());
+    for (size_t rank : ranks)
+        result.push_back(values[rank]);
+    return result;
+}
+
+// Percentiles in [0, 100] (e.g. 50, 90, 99), interpolating linearly between
+// the two closest ranks. All of them come from one multi-selection; 'values'
+// is reordered in place.
+inline vector<double> percentiles(vector<double> &values, const vector<double> &percents)
+{
+    vector<double> result;
+    if (values.empty())
+    {
+        result.assign(percents.size(), 0.0);
+        return result;
+    }
+
+    vector<size_t> ranks;
+    vector<double> positions;
+    for (double p : percents)
+    {
+        double position = std::clamp(p, 0.0, 100.0) / 100.0 * (values.size() - 1);
+        positions.push_back(position);
+        ranks.push_back(static_cast<size_t>(std::floor(position)));
+        ranks.push_back(static_cast<size_t>(std::ceil(position)));
+    }
+
+    vector<double> selected = orderStatistics(values, ranks);
+    for (size_t i = 0; i < percents.size(); ++i)
+    {
+        double low = selected[2 * i];
+        double high = selected[2 * i + 1];
+        result.push_back(low + (high - low) * (positions[i] - std::floor(positions[i])));
+    }
+    return result;
+}
+
+// Median and quartiles as the reports print them: the median is the middle
+// value (mean of the two middle ones for even counts), Q1/Q3 are the values
+// at ranks n/4 and 3n/4. One multi-selection; 'values' is reordered in place.
+struct Quartiles
+{
+    double q1 = 0.0;
+    double median = 0.0;
+    double q3 = 0.0;
+};
+
+inline Quartiles quartiles(vector<double> &values)
+{
+    Quartiles result;
+    size_t n = values.size();
+    if (n == 0)
+        return result;
+
+    size_t upperMiddle = n / 2;
+    size_t lowerMiddle = n % 2 == 0 ? upperMiddle - 1 : upperMiddle;
+    vector<double> selected = orderStatistics(values, {lowerMiddle, upperMiddle, n / 4, 3 * n / 4});
+    result.median = (selected[0] + selected[1]) / 2.0;
+    result.q1 = selected[2];
+    result.q3 = selected[3];
+    return result;
+}
+
+// KLL quantile sketch: keeps O(k log(n / k)) of the values it has seen and
+// answers any quantile with a rank error of roughly 1.7 / k^0.9 (about 1.5%
+// for the default k = 200). Level h holds values that each stand for 2^h
+// inputs; a full level is sorted and every other value is promoted. Sketches of
+// disjoint inputs (threads, chunks, files) merge into a sketch of the union.
+// Which half gets promoted is drawn from a fixed-seed generator, so the same
+// inputs in the same order always give the same answers.
+class QuantileSketch
+{
+private:
+    size_t k = 200;
+    vector<vector<double>> levels{vector<double>()};
+    vector<size_t> capacities; // per level, recomputed when a level is added
+    size_t capacityTotal = 0;
+    size_t retained = 0;
+    size_t count = 0;
+    double minValue = numeric_limits<double>::infinity();
+    double maxValue = -numeric_limits<double>::infinity();
+    uint64_t randomState = 0x9E3779B97F4A7C15ull;
+
+    // Level h may hold k * (2/3)^(depth) values, depth counted from the top
+    void updateCapacities()
+    {
+        capacities.resize(levels.size());
+        capacityTotal = 0;
+        for (size_t h = 0; h < levels.size(); ++h)
+        {
+            double depth = static_cast<double>(levels.size() - h - 1);
+            capacities[h] = std::max<size_t>(2, static_cast<size_t>(std::ceil(k * std::pow(2.0 / 3.0, depth))));
+            capacityTotal += capacities[h];
+        }
+    }
+
+    void addLevel()
+    {
+        levels.emplace_back();
+        updateCapacities();
+    }
+
+    bool randomBit()
+    {
+        randomState ^= randomState << 13;
+        randomState ^= randomState >> 7;
+        randomState ^= randomState << 17;
+        return randomState & 1;
+    }
+
+    // Compact the lowest level that is over capacity into the next one
+    void compress()
+    {
+        for (size_t h = 0; h < levels.size(); ++h)
+        {
+            if (levels[h].size() < capacities[h])
+                continue;
+            if (h + 1 == levels.size())
+                addLevel();
+
+            vector<double> &level = levels[h];
+            sort(level.begin(), level.end());
+            size_t paired = level.size() - level.size() % 2; // an odd value out stays here
+            for (size_t i = randomBit() ? 1 : 0; i < paired; i += 2)
+                levels[h + 1].push_back(level[i]);
+            level.erase(level.begin(), level.begin() + paired);
+
+            retained = 0;
+            for (const auto &l : levels)
+                retained += l.size();
+            return;
+        }
+    }
+
+    // All retained values with their weights, sorted by value
+    vector<pair<double, uint64_t>> weightedValues() const
+    {
+        vector<pair<double, uint64_t>> items;
+        items.reserve(retained);
+        for (size_t h = 0; h < levels.size(); ++h)
+        {
+            for (double v : levels[h])
+                items.emplace_back(v, uint64_t(1) << h);
+        }
+        sort(items.begin(), items.end());
+        return items;
+    }
+
+public:
+    // Larger k = more accurate and more memory (k values per level, roughly)
+    explicit QuantileSketch(size_t accuracy = 200) : k(std::max<size_t>(8, accuracy))
+    {
+        updateCapacities();
+    }
+
+    size_t getAccuracy() const { return k; }
+    size_t getCount() const { return count; }
+    size_t getRetainedCount() const { return retained; }
+    bool empty() const { return count == 0; }
+    double getMin() const { return minValue; }
+    double getMax() const { return maxValue; }
+
+    void add(double v)
+    {
+        if (std::isnan(v))
+            return;
+        levels[0].push_back(v);
+        retained++;
+        count++;
+        minValue = std::min(minValue, v);
+        maxValue = std::max(maxValue, v);
+        if (retained >= capacityTotal)
+            compress();
+    }
+
+    void merge(const QuantileSketch &other)
+    {
+        if (other.count == 0)
+            return;
+        while (levels.size() < other.levels.size())
+            addLevel();
+        for (size_t h = 0; h < other.levels.size(); ++h)
+            levels[h].insert(levels[h].end(), other.levels[h].begin(), other.levels[h].end());
+
+        retained += other.retained;
+        count += other.count;
+        minValue = std::min(minValue, other.minValue);
+        maxValue = std::max(maxValue, other.maxValue);
+        while (retained >= capacityTotal)
+            compress();
+    }
+
+    // Approximate values at the given percentiles (0-100). 0 and 100 are the
+    // exact min and max.
+    vector<double> percentiles(const vector<double> &percents) const
+    {
+        vector<double> result;
+        if (count == 0)
+        {
+            result.assign(percents.size(), 0.0);
+            return result;
+        }
+
+        vector<pair<double, uint64_t>> items = weightedValues();
+        uint64_t total = 0;
+        for (const auto &item : items)
+            total += item.second;
+
+        for (double p : percents)
+        {
+            double fraction = std::clamp(p, 0.0, 100.0) / 100.0;
+            if (fraction <= 0.0)
+            {
+                result.push_back(minValue);
+                continue;
+            }
+            if (fraction >= 1.0)
+            {
+                result.push_back(maxValue);
+                continue;
+            }
+
+            // First value whose cumulative weight reaches the target rank
+            double target = fraction * static_cast<double>(total);
+            uint64_t cumulative = 0;
+            double value = items.back().first;
+            for (const auto &item : items)
+            {
+                cumulative += item.second;
+                if (static_cast<double>(cumulative) >= target)
+                {
+                    value = item.first;
+                    break;
+                }
+            }
+            result.push_back(value);
+        }
+        return result;
+    }
+
+    double median() const { return percentiles({50.0})[0]; }
+
+    // Snapshot image (see Snapshot.h)
+    void write(ostream &out) const
+    {
+        writeValue(out, static_cast<uint64_t>(k));
+        writeValue(out, static_cast<uint64_t>(count));
+        writeValue(out, minValue);
+        writeValue(out, maxValue);
+        writeValue(out, randomState);
+        writeValue(out, static_cast<uint64_t>(levels.size()));
+        for (const auto &level : levels)
+            writeVector(out, level);
+    }
+
+    bool read(BinaryReader &in)
+    {
+        k = std::max<uint64_t>(8, in.value<uint64_t>());
+        count = in.value<uint64_t>();
+        minValue = in.value<double>();
+        maxValue = in.value<double>();
+        randomState = in.value<uint64_t>();
+        uint64_t levelCount = in.value<uint64_t>();
+        if (!in.ok() || levelCount == 0 || levelCount > 64)
+            return false;
+        levels.assign(levelCount, vector<double>());
+        retained = 0;
+        for (auto &level : levels)
+        {
+            in.readVector(level);
+            retained += level.size();
+        }
+        updateCapacities();
+        return in.ok();
+    }
+
+    // Approximate counts of 'bins' equal-width bins over [low, high] (values
+    // outside are clamped into the first/last bin); they add up to getCount()
+    vector<size_t> binCounts(double low, double high, size_t bins) const
+    {
+        vector<double> weights(bins, 0.0);
+        if (count == 0 || bins == 0)
+            return vector<size_t>(bins, 0);
+
+        double step = (high - low) / static_cast<double>(bins);
+        double total = 0.0;
+        for (size_t h = 0; h < levels.size(); ++h)
+        {
+            double weight = static_cast<double>(uint64_t(1) << h);
+            for (double v : levels[h])
+            {
+                double position = step > 0.0 ? (v - low) / step : 0.0;
+                size_t bin = position <= 0.0 ? 0 : std::min(bins - 1, static_cast<size_t>(position));
+                weights[bin] += weight;
+                total += weight;
+            }
+        }
+
+        vector<size_t> result(bins);
+        double scale = static_cast<double>(count) / total;
+        for (size_t b = 0; b < bins; ++b)
+            result[b] = static_cast<size_t>(std::llround(weights[b] * scale));
+        return result;
+    }
+
+    // Edges of 'bins' equal-count bins: bins + 1 values from min to max
+    vector<double> binEdges(size_t bins) const
+    {
+        vector<double> percents;
+        for (size_t i = 0; i <= bins; ++i)
+            percents.push_back(100.0 * static_cast<double>(i) / static_cast<double>(bins));
+        return percentiles(percents);
+    }
+};
+
+// Distinct-count estimate in fixed memory (HyperLogLog): the hash of each
+// value picks one of 4096 one-byte registers, which keeps the longest run of
+// leading zero bits seen there. Ertl's improved estimator reads the register
+// histogram without bias corrections, from a few values to billions, with a
+// relative standard error of 1.04 / sqrt(4096), about 1.6%. Counters merge
+// register by register, so row ranges and chunks are counted separately.
+class HyperLogLog
+{
+private:
+    static constexpr int precision = 12;
+    static constexpr size_t registerCount = size_t(1) << precision;
+    static constexpr int maxRank = 64 - precision + 1;
+    vector<uint8_t> registers = vector<uint8_t>(registerCount, 0);
+
+    static uint64_t mix(uint64_t x)
+    {
+        x ^= x >> 30;
+        x *= 0xbf58476d1ce4e5b9ULL;
+        x ^= x >> 27;
+        x *= 0x94d049bb133111ebULL;
+        x ^= x >> 31;
+        return x;
+    }
+
+    // Series of the estimator for the empty and the saturated registers
+    static double sigma(double x)
+    {
+        if (x == 1.0)
+            return numeric_limits<double>::infinity();
+        double y = 1.0, z = x, previous;
+        do
+        {
+            x *= x;
+            previous = z;
+            z += x * y;
+            y += y;
+        } while (z != previous);
+        return z;
+    }
+
+    static double tau(double x)
+    {
+        if (x == 0.0 || x == 1.0)
+            return 0.0;
+        double y = 1.0, z = 1.0 - x, previous;
+        do
+        {
+            x = sqrt(x);
+            previous = z;
+            y *= 0.5;
+            z -= (1.0 - x) * (1.0 - x) * y;
+        } while (z != previous);
+        return z / 3.0;
+    }
+
+public:
+    void addHash(uint64_t hash)
+    {
+        uint64_t x = mix(hash);
+        size_t index = static_cast<size_t>(x >> (64 - precision));
+        uint64_t rest = x << precision;
+        uint8_t rank = static_cast<uint8_t>(rest == 0 ? maxRank : __builtin_clzll(rest) + 1);
+        if (rank > registers[index])
+            registers[index] = rank;
+    }
+
+    void add(double value)
+    {
+        if (value == 0.0)
+            value = 0.0; // -0.0 and 0.0 are the same value
+        uint64_t bits;
+        memcpy(&bits, &value, sizeof(bits));
+        addHash(bits);
+    }
+
+    void merge(const HyperLogLog &other)
+    {
+        for (size_t i = 0; i < registerCount; ++i)
+            registers[i] = max(registers[i], other.registers[i]);
+    }
+
+    size_t estimate() const
+    {
+        size_t histogram[maxRank + 1] = {};
+        for (uint8_t rank : registers)
+            histogram[rank]++;
+        if (histogram[0] == registerCount)
+            return 0;
+
+        double m = static_cast<double>(registerCount);
+        double z = m * tau(1.0 - static_cast<double>(histogram[maxRank]) / m);
+        for (int k = maxRank - 1; k >= 1; --k)
+            z = 0.5 * (z + static_cast<double>(histogram[k]));
+        z += m * sigma(static_cast<double>(histogram[0]) / m);
+        return static_cast<size_t>(std::llround(m * m / (2.0 * std::log(2.0) * z)));
+    }
+
+    // Relative standard error of estimate()
+    static double relativeError() { return 1.04 / std::sqrt(static_cast<double>(registerCount)); }
+
+    void write(ostream &out) const
+    {
+        writeVector(out, registers);
+    }
+
+    bool read(BinaryReader &in)
+    {
+        in.readVector(registers);
+        if (!in.ok() || registers.size() != registerCount)
+            return false;
+        for (uint8_t rank : registers)
+        {
+            if (rank > maxRank)
+                return false;
+        }
+        return true;
+    }
+};
+
+// The 'k' best items offered, by 'better' (a strict order, best first): a
+// heap of k items replaces sorting everything when only the top is shown
+template <typename T, typename Better>
+class TopK
+{
+private:
+    size_t k;
+    Better better;
+    vector<T> heap; // heap.front() is the worst item kept
+
+public:
+    explicit TopK(size_t limit, Better order = Better()) : k(limit), better(order) {}
+
+    void offer(const T &item)
+    {
+        if (heap.size() < k)
+        {
+            heap.push_back(item);
+            push_heap(heap.begin(), heap.end(), better);
+        }
+        else if (k > 0 && better(item, heap.front()))
+        {
+            pop_heap(heap.begin(), heap.end(), better);
+            heap.back() = item;
+            push_heap(heap.begin(), heap.end(), better);
+        }
+    }
+
+    // The items kept, best first
+    vector<T> take()
+    {
+        sort_heap(heap.begin(), heap.end(), better);
+        return std::move(heap);
+    }
+};
+
+// Hash for integer keys (dates, codes): a full avalanche, since linear
+// probing needs the low bits to vary
+struct IntegerHash
+{
+    size_t operator()(int64_t value) const
+    {
+        uint64_t x = static_cast<uint64_t>(value);
+        x ^= x >> 30;
+        x *= 0xbf58476d1ce4e5b9ULL;
+        x ^= x >> 27;
+        x *= 0x94d049bb133111ebULL;
+        x ^= x >> 31;
+        return static_cast<size_t>(x);
+    }
+};
+
+// Occurrence counts in one flat open-addressing table (linear probing, kept at
+// most half full), so counting touches one array instead of a node per value.
+// Each key also keeps the first row it was seen in; partial counters built
+// over row ranges merge into the same result in any order.
+template <typename Key, typename Hash>
+class FlatCounter
+{
+public:
+    struct Entry
+    {
+        Key key{};
+        size_t count = 0; // 0 = empty slot
+        size_t firstRow = 0;
+    };
+
+private:
+    vector<Entry> slots;
+    size_t used = 0;
+    Hash hasher;
+
+    void grow()
+    {
+        vector<Entry> old = std::move(slots);
+        slots.assign(old.size() * 2, Entry());
+        used = 0;
+        for (const auto &entry : old)
+        {
+            if (entry.count > 0)
+                add(entry.key, entry.firstRow, entry.count);
+        }
+    }
+
+public:
+    explicit FlatCounter(size_t expected = 0)
+    {
+        size_t capacity = 16;
+        while (capacity < 2 * expected)
+            capacity <<= 1;
+        slots.assign(capacity, Entry());
+    }
+
+    void add(const Key &key, size_t row, size_t times = 1)
+    {
+        if (2 * (used + 1) > slots.size())
+            grow();
+        size_t mask = slots.size() - 1;
+        for (size_t i = hasher(key) & mask;; i = (i + 1) & mask)
+        {
+            Entry &entry = slots[i];
+            if (entry.count == 0)
+            {
+                entry = Entry{key, times, row};
+                used++;
+                return;
+            }
+            if (entry.key == key)
+            {
+                entry.count += times;
+                entry.firstRow = min(entry.firstRow, row);
+                return;
+            }
+        }
+    }
+
+    void merge(const FlatCounter &other)
+    {
+        for (const auto &entry : other.slots)
+        {
+            if (entry.count > 0)
+                add(entry.key, entry.firstRow, entry.count);
+        }
+    }
+
+    // Distinct keys counted
+    size_t size() const { return used; }
+
+    // Forget every key but keep the table, for the next block of rows
+    void clear()
+    {
+        fill(slots.begin(), slots.end(), Entry());
+        used = 0;
+    }
+
+    template <typename F>
+    void forEach(F &&fn) const
+    {
+        for (const auto &entry : slots)
+        {
+            if (entry.count > 0)
+                fn(entry);
+        }
+    }
+
+    // The 'k' most frequent keys, most frequent first (ties: smaller key first)
+    vector<Entry> top(size_t k) const
+    {
+        auto better = [](const Entry &a, const Entry &b)
+        { return a.count != b.count ? a.count > b.count : a.key < b.key; };
+        TopK<Entry, decltype(better)> best(k, better);
+        forEach([&](const Entry &entry)
+                { best.offer(entry); });
+        return best.take();
+    }
+};
+
+// Heavy hitters in fixed memory (Space-Saving): at most 'capacity' values are
+// counted; a new value replaces the least counted one and inherits its count
+// as possible overcount ('error'). Any value seen more than total / capacity
+// times is kept, and a kept value's true count lies in [count - error, count].
+// Summaries of separate row ranges merge into one with the same guarantees.
+class SpaceSaving
+{
+public:
+    struct Counter
+    {
+        string value;
+        uint64_t count = 0;
+        uint64_t error = 0;
+    };
+
+private:
+    size_t capacity;
+    vector<Counter> counters; // fixed slots, referenced by 'index' and 'heap'
+    unordered_map<string, uint32_t, StringViewHash, equal_to<>> index;
+    vector<uint32_t> heap;     // slots, least counted first
+    vector<uint32_t> position; // slot -> place in 'heap'
+
+    bool less(uint32_t a, uint32_t b) const { return counters[a].count < counters[b].count; }
+
+    void place(size_t at, uint32_t slot)
+    {
+        heap[at] = slot;
+        position[slot] = static_cast<uint32_t>(at);
+    }
+
+    void siftUp(size_t at)
+    {
+        uint32_t slot = heap[at];
+        while (at > 0 && less(slot, heap[(at - 1) / 2]))
+        {
+            place(at, heap[(at - 1) / 2]);
+            at = (at - 1) / 2;
+        }
+        place(at, slot);
+    }
+
+    // After the count of heap[at] grew
+    void siftDown(size_t at)
+    {
+        uint32_t slot = heap[at];
+        while (true)
+        {
+            size_t child = 2 * at + 1;
+            if (child >= heap.size())
+                break;
+            if (child + 1 < heap.size() && less(heap[child + 1], heap[child]))
+                child++;
+            if (!less(heap[child], slot))
+                break;
+            place(at, heap[child]);
+            at = child;
+        }
+        place(at, slot);
+    }
+
+    void insert(Counter counter)
+    {
+        uint32_t slot = static_cast<uint32_t>(counters.size());
+        index.emplace(counter.value, slot);
+        counters.push_back(std::move(counter));
+        heap.push_back(slot);
+        position.push_back(0);
+        siftUp(heap.size() - 1);
+    }
+
+    // Keep the 'capacity' largest of 'candidates'
+    void rebuild(vector<Counter> candidates)
+    {
+        sort(candidates.begin(), candidates.end(), [](const Counter &a, const Counter &b)
+             { return a.count != b.count ? a.count > b.count : a.value < b.value; });
+        if (candidates.size() > capacity)
+            candidates.resize(capacity);
+        counters.clear();
+        index.clear();
+        heap.clear();
+        position.clear();
+        for (auto &counter : candidates)
+            insert(std::move(counter));
+    }
+
+public:
+    explicit SpaceSaving(size_t maxValues = 256) : capacity(max<size_t>(maxValues, 1)) {}
+
+    void add(string_view value, uint64_t times = 1)
+    {
+        auto it = index.find(value);
+        if (it != index.end())
+        {
+            counters[it->second].count += times;
+            siftDown(position[it->second]);
+        }
+        else if (counters.size() < capacity)
+        {
+            insert(Counter{string(value), times, 0});
+        }
+        else
+        {
+            // Evict the least counted value; the newcomer may have had as many
+            uint32_t slot = heap[0];
+            Counter &counter = counters[slot];
+            uint64_t floor = counter.count;
+            index.erase(counter.value);
+            counter.value.assign(value.data(), value.size());
+            counter.count = floor + times;
+            counter.error = floor;
+            index.emplace(counter.value, slot);
+            siftDown(0);
+        }
+    }
+
+    // A value not kept was seen at most this many times
+    uint64_t minimum() const { return counters.size() < capacity ? 0 : counters[heap[0]].count; }
+
+    // Agarwal et al.: a value missing from one side may have been counted
+    // there up to that side's minimum
+    void merge(const SpaceSaving &other)
+    {
+        uint64_t ownFloor = minimum(), otherFloor = other.minimum();
+        vector<Counter> combined;
+        combined.reserve(counters.size() + other.counters.size());
+        for (const auto &counter : counters)
+        {
+            auto it = other.index.find(counter.value);
+            if (it != other.index.end())
+            {
+                const Counter &match = other.counters[it->second];
+                combined.push_back(Counter{counter.value, counter.count + match.count, counter.error + match.error});
+            }
+            else
+            {
+                combined.push_back(Counter{counter.value, counter.count + otherFloor, counter.error + otherFloor});
+            }
+        }
+        for (const auto &counter : other.counters)
+        {
+            if (index.find(counter.value) == index.end())
+                combined.push_back(Counter{counter.value, counter.count + ownFloor, counter.error + ownFloor});
+        }
+        rebuild(std::move(combined));
+    }
+
+    size_t getCapacity() const { return capacity; }
+    const vector<Counter> &getCounters() const { return counters; }
+
+    // Replace the summary by 'exact' counts of at most getCapacity() values,
+    // where any value left out was seen at most as often as the least of them
+    void assign(vector<Counter> exact)
+    {
+        rebuild(std::move(exact));
+    }
+
+    void write(ostream &out) const
+    {
+        writeValue(out, static_cast<uint64_t>(capacity));
+        writeValue(out, static_cast<uint64_t>(counters.size()));
+        for (const auto &counter : counters)
+        {
+            writeString(out, counter.value);
+            writeValue(out, counter.count);
+            writeValue(out, counter.error);
+        }
+    }
+
+    bool read(BinaryReader &in)
+    {
+        capacity = in.value<uint64_t>();
+        uint64_t size = in.value<uint64_t>();
+        if (!in.ok() || capacity == 0 || capacity > (size_t(1) << 20) || size > capacity)
+            return false;
+        vector<Counter> loaded(size);
+        for (auto &counter : loaded)
+        {
+            counter.value = in.text();
+            counter.count = in.value<uint64_t>();
+            counter.error = in.value<uint64_t>();
+            if (counter.error > counter.count)
+                return false;
+        }
+        if (!in.ok())
+            return false;
+        rebuild(std::move(loaded));
+        return true;
+    }
+};
+
+// Upper bounds for the count of any value (Count-Min): 4 rows of 512 counters
+// (16 KB), each value adds to one counter per row and its estimate is the
+// smallest of them. It never undercounts, and overcounts by more than e / 512
+// of the total (about 0.5%) with probability below e^-4 (about 2%). Counters
+// are only allocated on the first add.
+class CountMinSketch
+{
+private:
+    static constexpr size_t depth = 4;
+    static constexpr size_t width = 512;
+    vector<uint64_t> cells; // depth rows of width counters
+    uint64_t total = 0;
+
+    // Counter of 'row' for a value (double hashing of one 64-bit mix)
+    static size_t cell(uint64_t hash, size_t row)
+    {
+        hash ^= hash >> 33;
+        hash *= 0xff51afd7ed558ccdULL;
+        hash ^= hash >> 33;
+        uint64_t step = (hash >> 32) | 1;
+        return row * width + ((hash + row * step) & (width - 1));
+    }
+
+public:
+    void add(uint64_t hash, uint64_t times = 1)
+    {
+        if (cells.empty())
+            cells.assign(depth * width, 0);
+        for (size_t row = 0; row < depth; ++row)
+            cells[cell(hash, row)] += times;
+        total += times;
+    }
+
+    uint64_t estimate(uint64_t hash) const
+    {
+        if (cells.empty())
+            return 0;
+        uint64_t best = numeric_limits<uint64_t>::max();
+        for (size_t row = 0; row < depth; ++row)
+            best = min(best, cells[cell(hash, row)]);
+        return best;
+    }
+
+    void merge(const CountMinSketch &other)
+    {
+        if (other.cells.empty())
+            return;
+        if (cells.empty())
+            cells.assign(depth * width, 0);
+        for (size_t i = 0; i < cells.size(); ++i)
+            cells[i] += other.cells[i];
+        total += other.total;
+    }
+
+    uint64_t getTotal() const { return total; }
+
+    void write(ostream &out) const
+    {
+        writeValue(out, total);
+        writeVector(out, cells);
+    }
+
+    bool read(BinaryReader &in)
+    {
+        total = in.value<uint64_t>();
+        in.readVector(cells);
+        return in.ok() && (cells.empty() || cells.size() == depth * width);
+    }
+};
+
+// Most frequent text values of a column in fixed memory: Space-Saving keeps
+// the candidates and Count-Min tightens their upper bounds (merged summaries
+// accumulate Space-Saving error that Count-Min does not). Exact while the
+// column has at most 256 distinct values.
+class FrequencySketch
+{
+private:
+    SpaceSaving tracked;
+    CountMinSketch counts;
+
+public:
+    struct HeavyHitter
+    {
+        string value;
+        size_t count = 0; // best estimate (upper bound)
+        size_t lower = 0; // the true count is in [lower, count]
+    };
+
+    void add(string_view value, size_t times = 1)
+    {
+        tracked.add(value, times);
+        counts.add(StringViewHash()(value), times);
+    }
+
+    // Fold in the exact counts of one block of values: its most frequent
+    // values are merged as one summary, so the rest never reach Space-Saving.
+    // With 'distinct', the values are also added to it (hashed only once).
+    void add(const FlatCounter<string_view, StringViewHash> &block, HyperLogLog *distinct = nullptr)
+    {
+        vector<SpaceSaving::Counter> best;
+        for (const auto &entry : block.top(tracked.getCapacity()))
+            best.push_back(SpaceSaving::Counter{string(entry.key), entry.count, 0});
+        SpaceSaving summary(tracked.getCapacity());
+        summary.assign(std::move(best));
+        tracked.merge(summary);
+        block.forEach([&](const auto &entry)
+                      {
+                          size_t hash = StringViewHash()(entry.key);
+                          counts.add(hash, entry.count);
+                          if (distinct)
+                              distinct->addHash(hash); });
+    }
+
+    void merge(const FrequencySketch &other)
+    {
+        tracked.merge(other.tracked);
+        counts.merge(other.counts);
+    }
+
+    bool empty() const { return counts.getTotal() == 0; }
+    size_t total() const { return counts.getTotal(); }
+
+    // Values not in the summary were seen at most this many times each
+    size_t unlistedBound() const { return tracked.minimum(); }
+
+    // The 'n' values with the highest estimates, highest first
+    vector<HeavyHitter> top(size_t n) const
+    {
+        vector<HeavyHitter> result;
+        for (const auto &counter : tracked.getCounters())
+        {
+            uint64_t upper = min(counter.count, counts.estimate(StringViewHash()(counter.value)));
+            result.push_back(HeavyHitter{counter.value, upper, counter.count - counter.error});
+        }
+        sort(result.begin(), result.end(), [](const HeavyHitter &a, const HeavyHitter &b)
+             {
+                 if (a.count != b.count)
+                     return a.count > b.count;
+                 return a.lower != b.lower ? a.lower > b.lower : a.value < b.value; });
+        if (result.size() > n)
+            result.resize(n);
+        return result;
+    }
+
+    void write(ostream &out) const
+    {
+        tracked.write(out);
+        counts.write(out);
+    }
+
+    bool read(BinaryReader &in)
+    {
+        return tracked.read(in) && counts.read(in);
+    }
+};
+
+// What the reports show about a whole column, gathered in one pass so that the
+// summary, the histogram and the TXT export share it. Numeric fields are only
+// filled for INTEGER/FLOAT columns. Rows appended later are folded in with
+// updateColumnStats without revisiting the ones already counted.
+struct ColumnStats
+{
+    size_t rows = 0;     // rows folded in so far
+    size_t count = 0;    // present values
+    size_t nulls = 0;    // empty, N/A or unparseable cells
+    size_t distinct = 0; // distinct present values (estimated)
+    NumericSummary summary;
+    Quartiles quarters;
+    double p90 = 0.0;
+    double p99 = 0.0;
+    bool quantilesReady = false;   // quarters/p90/p99 cover every folded row
+    vector<size_t> categoryCounts; // CATEGORY: occurrences per dictionary code
+    HyperLogLog distinctValues;
+    FrequencySketch topValues; // STRING: heavy hitters, for high-cardinality columns
+};
+
+// Rows per block whose STRING values are counted together before they reach
+// the heavy-hitter sketch, so each distinct value of a block is added once
+inline constexpr size_t frequencyBlockRows = 1 << 16;
+
+// Exact quartiles and P90/P99 of the non-null values in 'values' (reordered)
+inline void setQuantiles(ColumnStats &stats, vector<double> &values)
+{
+    if (!values.empty())
+    {
+        stats.quarters = quartiles(values);
+        vector<double> tail = percentiles(values, {90, 99});
+        stats.p90 = tail[0];
+        stats.p99 = tail[1];
+    }
+    stats.quantilesReady = true;
+}
+
+// Exact quantiles need every value, so after an incremental update they are
+// recomputed from the column (by selection, not sorting) when asked for
+inline void computeColumnQuantiles(ColumnStats &stats, const Column &column)
+{
+    vector<double> values;
+    values.reserve(column.size() - column.getNullCount());
+    column.forEachNumeric([&](double v)
+                          { values.push_back(v); });
+    setQuantiles(stats, values);
+}
+
+// Fields derived from the running counts once rows have been folded in
+inline void finishColumnStats(ColumnStats &stats, const Column &column)
+{
+    if (column.getType() == DataType::CATEGORY)
+    {
+        // Present values are decided per dictionary entry
+        const auto &dictionary = column.getDictionary();
+        stats.count = 0;
+        stats.distinct = 0;
+        for (size_t d = 0; d < stats.categoryCounts.size(); ++d)
+        {
+            if (stats.categoryCounts[d] > 0 && !dictionary[d].empty() && dictionary[d] != "N/A")
+            {
+                stats.count += stats.categoryCounts[d];
+                stats.distinct++;
+            }
+        }
+    }
+    else
+    {
+        stats.distinct = stats.distinctValues.estimate();
+    }
+
+    if (!column.isNumeric())
+        stats.quantilesReady = true;
+    if (stats.count == 0)
+        stats.distinct = 0;
+    stats.nulls = stats.rows - stats.count;
+}
+
+// Fold rows [stats.rows, lastRow) (by default up to column.size()) into
+// 'stats': counts, moments (merged Welford/Chan style), min/max, the distinct
+// counter, category counts and the heavy hitters of text columns. An update
+// covering the whole column from row 0 also computes the quantiles; others
+// leave them stale (quantilesReady = false) until computeColumnQuantiles runs.
+inline void updateColumnStats(ColumnStats &stats, const Column &column,
+                              size_t lastRow = static_cast<size_t>(-1))
+{
+    size_t first = stats.rows;
+    size_t end = min(lastRow, column.size());
+
+    switch (column.getType())
+    {
+    case DataType::INTEGER:
+    case DataType::FLOAT:
+    {
+        vector<double> values;
+        values.reserve(end - first);
+        column.forEachNumericFrom(first, [&](double v)
+                                  { values.push_back(v); stats.distinctValues.add(v); },
+                                  end);
+        stats.count += values.size();
+        stats.summary.merge(summarizeValues(values.data(), values.size()));
+        if (first == 0 && end == column.size())
+            setQuantiles(stats, values);
+        else if (!values.empty())
+            stats.quantilesReady = false;
+        break;
+    }
+    case DataType::DATE:
+    {
+        const vector<int32_t> &dates = column.getDates();
+        for (size_t r = first; r < end; ++r)
+        {
+            if (!column.isNull(r))
+            {
+                stats.count++;
+                stats.distinctValues.addHash(static_cast<uint32_t>(dates[r]));
+            }
+        }
+        break;
+    }
+    case DataType::CATEGORY:
+        // Running counts per code; the count itself comes from them
+        column.countCategories(stats.categoryCounts, first, end);
+        break;
+    case DataType::STRING:
+    {
+        FlatCounter<string_view, StringViewHash> counts;
+        for (size_t block = first; block < end; block += frequencyBlockRows)
+        {
+            counts.clear();
+            for (size_t r = block; r < min(end, block + frequencyBlockRows); ++r)
+            {
+                string_view value = column.getView(r);
+                if (!value.empty() && value != "N/A")
+                {
+                    counts.add(value, r);
+                    stats.count++;
+                }
+            }
+            stats.topValues.add(counts, &stats.distinctValues);
+        }
+        break;
+    }
+    }
+
+    stats.rows = end;
+    finishColumnStats(stats, column);
+}
+
+// Stats of rows [first, last) of 'column', to be merged with mergeColumnStats
+// into the stats that end at row 'first'; lets one column be folded in
+// row ranges by several threads
+inline ColumnStats columnStatsOfRows(const Column &column, size_t first, size_t last)
+{
+    ColumnStats part;
+    part.rows = first;
+    updateColumnStats(part, column, last);
+    return part;
+}
+
+// Append the range 'part' (see columnStatsOfRows) to 'stats', which must end
+// where 'part' starts
+inline void mergeColumnStats(ColumnStats &stats, const ColumnStats &part, const Column &column)
+{
+    if (column.getType() != DataType::CATEGORY)
+        stats.count += part.count;
+    stats.summary.merge(part.summary);
+    stats.distinctValues.merge(part.distinctValues);
+    stats.topValues.merge(part.topValues);
+    stats.categoryCounts.resize(max(stats.categoryCounts.size(), part.categoryCounts.size()), 0);
+    for (size_t d = 0; d < part.categoryCounts.size(); ++d)
+        stats.categoryCounts[d] += part.categoryCounts[d];
+    if (column.isNumeric() && part.count > 0)
+        stats.quantilesReady = false;
+    stats.rows = part.rows;
+    finishColumnStats(stats, column);
+}
+
+// Snapshot image of a ColumnStats (see Snapshot.h)
+inline void writeColumnStats(ostream &out, const ColumnStats &stats)
+{
+    writeValue(out, static_cast<uint64_t>(stats.rows));
+    writeValue(out, static_cast<uint64_t>(stats.count));
+    writeValue(out, static_cast<uint64_t>(stats.distinct));
+    writeValue(out, stats.summary);
+    writeValue(out, stats.quarters);
+    writeValue(out, stats.p90);
+    writeValue(out, stats.p99);
+    writeValue(out, static_cast<uint8_t>(stats.quantilesReady));
+    vector<uint64_t> counts(stats.categoryCounts.begin(), stats.categoryCounts.end());
+    writeVector(out, counts);
+    stats.distinctValues.write(out);
+    stats.topValues.write(out);
+}
+
+inline bool readColumnStats(BinaryReader &in, ColumnStats &stats)
+{
+    stats.rows = in.value<uint64_t>();
+    stats.count = in.value<uint64_t>();
+    stats.distinct = in.value<uint64_t>();
+    stats.summary = in.value<NumericSummary>();
+    stats.quarters = in.value<Quartiles>();
+    stats.p90 = in.value<double>();
+    stats.p99 = in.value<double>();
+    stats.quantilesReady = in.value<uint8_t>() != 0;
+    vector<uint64_t> counts;
+    in.readVector(counts);
+    stats.categoryCounts.assign(counts.begin(), counts.end());
+    stats.nulls = stats.rows - stats.count;
+    return stats.distinctValues.read(in) && stats.topValues.read(in) && in.ok() &&
+           stats.count <= stats.rows;
+}
+
+inline ColumnStats computeColumnStats(const Column &column)
+{
+    ColumnStats stats;
+    updateColumnStats(stats, column);
+    return stats;
+}
+
+// Per-column results of a streaming pass: everything is mergeable and of
+// bounded size, so a file of any length is summarized chunk by chunk without
+// keeping its rows
+struct StreamColumnStats
+{
+    size_t count = 0; // present values
+    size_t nulls = 0;
+    size_t parseFailures = 0;
+    NumericSummary summary;      // INTEGER/FLOAT
+    QuantileSketch sketch;       // INTEGER/FLOAT (empty when sketches are off)
+    FrequencySketch frequency;   // CATEGORY/STRING
+    HyperLogLog distinctValues;  // every column
+
+    // Fold in one chunk of the column
+    void add(const Column &column)
+    {
+        size_t present = 0;
+        if (column.getType() == DataType::CATEGORY)
+        {
+            const auto &dictionary = column.getDictionary();
+            vector<size_t> counts = column.countCategories();
+            for (size_t d = 0; d < counts.size(); ++d)
+            {
+                if (counts[d] > 0 && !dictionary[d].empty() && dictionary[d] != "N/A")
+                {
+                    frequency.add(dictionary[d], counts[d]);
+                    distinctValues.addHash(StringViewHash()(dictionary[d]));
+                    present += counts[d];
+                }
+            }
+        }
+        else if (column.getType() == DataType::STRING)
+        {
+            // Count within the chunk first so the sketches see each value once
+            FlatCounter<string_view, StringViewHash> counts;
+            for (size_t r = 0; r < column.size(); ++r)
+            {
+                string_view value = column.getView(r);
+                if (!value.empty() && value != "N/A")
+                    counts.add(value, r);
+            }
+            counts.forEach([&](const auto &entry)
+                           { present += entry.count; });
+            frequency.add(counts, &distinctValues);
+        }
+        else if (column.getType() == DataType::DATE)
+        {
+            present = column.size() - column.getNullCount();
+            const vector<int32_t> &dates = column.getDates();
+            for (size_t r = 0; r < column.size(); ++r)
+            {
+                if (!column.isNull(r))
+                    distinctValues.addHash(static_cast<uint32_t>(dates[r]));
+            }
+        }
+        else
+        {
+            present = column.size() - column.getNullCount();
+            summary.merge(summarizeColumn(column));
+            column.forEachNumeric([&](double v)
+                                  { distinctValues.add(v); });
+        }
+
+        count += present;
+        nulls += column.size() - present;
+        parseFailures += column.getParseFailureCount();
+    }
+
+    void merge(const StreamColumnStats &other)
+    {
+        count += other.count;
+        nulls += other.nulls;
+        parseFailures += other.parseFailures;
+        summary.merge(other.summary);
+        sketch.merge(other.sketch);
+        frequency.merge(other.frequency);
+        distinctValues.merge(other.distinctValues);
+    }
+};
+
+#endif // ESTADISTICAS_H
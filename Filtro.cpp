@@ -0,0 +1 @@
+#include "Filtro.h"
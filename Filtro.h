@@ -0,0 +1,715 @@
+#ifndef FILTRO_H
+#define FILTRO_H
+
+#include "Columna.h"
+#include "Planificador.h"
+#include <cmath>
+#include <functional>
+#include <type_traits>
+#include <cctype>
+#include <bit>
+
+using namespace std;
+
+enum class CompareOp
+{
+    EQ,
+    NE,
+    GT,
+    LT,
+    GE,
+    LE,
+    CONTAINS
+};
+
+// Map the operator typed by the user ("=", "==", "!=", ">", "<", ">=", "<=",
+// "contains") to a CompareOp. Returns false for anything else.
+inline bool parseCompareOp(const string &text, CompareOp &op)
+{
+    if (text == "==" || text == "=")
+        op = CompareOp::EQ;
+    else if (text == "!=")
+        op = CompareOp::NE;
+    else if (text == ">")
+        op = CompareOp::GT;
+    else if (text == "<")
+        op = CompareOp::LT;
+    else if (text == ">=")
+        op = CompareOp::GE;
+    else if (text == "<=")
+        op = CompareOp::LE;
+    else if (text == "contains")
+        op = CompareOp::CONTAINS;
+    else
+        return false;
+    return true;
+}
+
+// Filter results as one bit per row, 64 rows per word (bit i % 64 of word i / 64)
+using RowBits = vector<uint64_t>;
+
+inline size_t rowBitWords(size_t rows)
+{
+    return (rows + 63) / 64;
+}
+
+// Number of rows whose bit is set
+inline size_t countRowBits(const RowBits &bits)
+{
+    size_t total = 0;
+    for (uint64_t word : bits)
+        total += static_cast<size_t>(popcount(word));
+    return total;
+}
+
+// Words of row bits per scheduler task when a filter is evaluated in parallel
+inline constexpr size_t filterGrainWords = 4096;
+
+// Run 'fn(firstWord, lastWord)' over [0, words), split across 'scheduler' if
+// given; every range writes its own words, so no synchronization is needed
+template <typename F>
+inline void forEachWordRange(size_t words, TaskScheduler *scheduler, F &&fn)
+{
+    if (scheduler && words > filterGrainWords)
+        scheduler->parallelRange(words, filterGrainWords, fn);
+    else
+        fn(size_t(0), words);
+}
+
+// Set bit i of 'bits' to test(i) for every row. The loop body has no branches,
+// so it stays a straight scan over the typed column. With 'within', words that
+// are zero there are left zero without being tested.
+template <typename Test>
+inline void evaluateRowBits(size_t rows, Test test, RowBits &bits, const RowBits *within = nullptr,
+                            TaskScheduler *scheduler = nullptr)
+{
+    bits.assign(rowBitWords(rows), 0);
+    size_t fullWords = rows / 64;
+    forEachWordRange(fullWords, scheduler, [&](size_t firstWord, size_t lastWord)
+                     {
+        for (size_t w = firstWord; w < lastWord; ++w)
+        {
+            if (within && (*within)[w] == 0)
+                continue;
+            size_t base = w * 64;
+            uint64_t word = 0;
+            for (unsigned b = 0; b < 64; ++b)
+            {
+                word |= static_cast<uint64_t>(test(base + b)) << b;
+            }
+            bits[w] = word;
+        } });
+    if (within && fullWords < bits.size() && (*within)[fullWords] == 0)
+        return;
+    for (size_t i = fullWords * 64; i < rows; ++i)
+    {
+        bits[i / 64] |= static_cast<uint64_t>(test(i)) << (i % 64);
+    }
+}
+
+// Clear the bits of null cells (they never match a comparison)
+inline void clearNullRows(const Column &column, RowBits &bits, TaskScheduler *scheduler = nullptr)
+{
+    if (!column.hasNulls())
+        return;
+    forEachWordRange(rowBitWords(column.size()), scheduler, [&](size_t firstWord, size_t lastWord)
+                     {
+        size_t end = min(column.size(), lastWord * 64);
+        for (size_t i = firstWord * 64; i < end; ++i)
+        {
+            bits[i / 64] &= ~(static_cast<uint64_t>(column.isNull(i)) << (i % 64));
+        } });
+}
+
+// Row indices of the set bits, in ascending order
+inline vector<size_t> collectRows(const RowBits &bits)
+{
+    vector<size_t> rows;
+    for (size_t w = 0; w < bits.size(); ++w)
+    {
+        uint64_t word = bits[w];
+        while (word)
+        {
+            rows.push_back(w * 64 + static_cast<size_t>(__builtin_ctzll(word)));
+            word &= word - 1;
+        }
+    }
+    return rows;
+}
+
+// Rows picked by a filter or a search: ascending indices into the loaded table.
+// Consumers read the table in place, so a selection costs one index per row
+// no matter how wide the rows are.
+class RowSelection
+{
+private:
+    vector<size_t> rows;
+
+public:
+    RowSelection() = default;
+    explicit RowSelection(vector<size_t> rowIndices) : rows(std::move(rowIndices)) {}
+
+    static RowSelection fromBits(const RowBits &bits) { return RowSelection(collectRows(bits)); }
+
+    size_t size() const { return rows.size(); }
+    bool empty() const { return rows.empty(); }
+    size_t operator[](size_t i) const { return rows[i]; }
+    vector<size_t>::const_iterator begin() const { return rows.begin(); }
+    vector<size_t>::const_iterator end() const { return rows.end(); }
+    const vector<size_t> &getRows() const { return rows; }
+};
+
+// Comparison of one cell against the operand, fixed at compile time. Numbers
+// compare as doubles and treat values within 1e-9 as equal.
+template <CompareOp Op>
+struct Compare
+{
+    template <typename T, typename U>
+    bool operator()(const T &cell, const U &operand) const
+    {
+        if constexpr (is_floating_point_v<U>)
+        {
+            double v = static_cast<double>(cell);
+            if constexpr (Op == CompareOp::EQ)
+                return std::abs(v - operand) < 1e-9;
+            else if constexpr (Op == CompareOp::NE)
+                return std::abs(v - operand) >= 1e-9;
+            else if constexpr (Op == CompareOp::GT)
+                return v > operand;
+            else if constexpr (Op == CompareOp::LT)
+                return v < operand;
+            else if constexpr (Op == CompareOp::GE)
+                return v >= operand;
+            else if constexpr (Op == CompareOp::LE)
+                return v <= operand;
+            else
+                return false; // 'contains' does not apply to numbers
+        }
+        else
+        {
+            if constexpr (Op == CompareOp::EQ)
+                return cell == operand;
+            else if constexpr (Op == CompareOp::NE)
+                return cell != operand;
+            else if constexpr (Op == CompareOp::GT)
+                return cell > operand;
+            else if constexpr (Op == CompareOp::LT)
+                return cell < operand;
+            else if constexpr (Op == CompareOp::GE)
+                return cell >= operand;
+            else if constexpr (Op == CompareOp::LE)
+                return cell <= operand;
+            else
+                return string_view(cell).find(operand) != string_view::npos;
+        }
+    }
+};
+
+// Call fn(integral_constant<CompareOp, op>) so each operator gets its own
+// instantiation of the kernel
+template <typename F>
+inline void dispatchCompareOp(CompareOp op, F &&fn)
+{
+    switch (op)
+    {
+    case CompareOp::EQ:
+        fn(integral_constant<CompareOp, CompareOp::EQ>{});
+        break;
+    case CompareOp::NE:
+        fn(integral_constant<CompareOp, CompareOp::NE>{});
+        break;
+    case CompareOp::GT:
+        fn(integral_constant<CompareOp, CompareOp::GT>{});
+        break;
+    case CompareOp::LT:
+        fn(integral_constant<CompareOp, CompareOp::LT>{});
+        break;
+    case CompareOp::GE:
+        fn(integral_constant<CompareOp, CompareOp::GE>{});
+        break;
+    case CompareOp::LE:
+        fn(integral_constant<CompareOp, CompareOp::LE>{});
+        break;
+    case CompareOp::CONTAINS:
+        fn(integral_constant<CompareOp, CompareOp::CONTAINS>{});
+        break;
+    }
+}
+
+// Fills one bit per row; the optional mask limits which words are computed,
+// and the optional scheduler splits the scan in word ranges
+using FilterKernel = function<void(RowBits &, const RowBits *, TaskScheduler *)>;
+
+// A "column <op> value" condition with the column type, operator and operand
+// resolved once. evaluate() then runs one typed loop over the column with no
+// per-row decisions about types or operators.
+class ColumnPredicate
+{
+private:
+    FilterKernel kernel;
+
+    // Build the kernel for a numeric or date column stored as 'values'
+    template <typename T, typename U>
+    static FilterKernel compileOrdered(const Column &column, const vector<T> &values,
+                                                    CompareOp op, U operand)
+    {
+        FilterKernel result;
+        dispatchCompareOp(op, [&](auto opTag)
+                          {
+            constexpr CompareOp Op = decltype(opTag)::value;
+            if constexpr (Op != CompareOp::CONTAINS)
+            {
+                result = [&column, &values, operand](RowBits &bits, const RowBits *within, TaskScheduler *scheduler)
+                {
+                    const T *cells = values.data();
+                    evaluateRowBits(values.size(), [cells, operand](size_t i)
+                                    { return Compare<Op>{}(cells[i], operand); }, bits, within, scheduler);
+                    clearNullRows(column, bits, scheduler);
+                };
+            } });
+        return result;
+    }
+
+    // Categories: decide the condition once per dictionary entry, then each
+    // row is a table lookup by code
+    static FilterKernel compileCategory(const Column &column, CompareOp op, const string &operand)
+    {
+        const auto &dictionary = column.getDictionary();
+        vector<uint8_t> table(dictionary.size(), 0);
+        dispatchCompareOp(op, [&](auto opTag)
+                          {
+            constexpr CompareOp Op = decltype(opTag)::value;
+            for (size_t d = 0; d < dictionary.size(); ++d)
+                table[d] = Compare<Op>{}(string_view(dictionary[d]), string_view(operand)); });
+
+        return [&column, table = std::move(table)](RowBits &bits, const RowBits *within, TaskScheduler *scheduler)
+        {
+            column.getCodes().visit([&](const auto &codes)
+                                    {
+                const auto *cells = codes.data();
+                const uint8_t *lookup = table.data();
+                evaluateRowBits(codes.size(), [cells, lookup](size_t i)
+                                { return lookup[cells[i]]; }, bits, within, scheduler); });
+        };
+    }
+
+    static FilterKernel compileString(const Column &column, CompareOp op, const string &operand)
+    {
+        FilterKernel result;
+        dispatchCompareOp(op, [&](auto opTag)
+                          {
+            constexpr CompareOp Op = decltype(opTag)::value;
+            result = [&column, operand](RowBits &bits, const RowBits *within, TaskScheduler *scheduler)
+            {
+                string_view target(operand);
+                evaluateRowBits(column.size(), [&column, target](size_t i)
+                                { return Compare<Op>{}(column.getView(i), target); }, bits, within, scheduler);
+            }; });
+        return result;
+    }
+
+public:
+    ColumnPredicate() = default;
+
+    // Resolve 'operation' and 'value' against 'column'. Returns false (and sets
+    // 'error') if the operator is unknown, does not apply to the column type,
+    // or the value cannot be converted to it. 'column' must outlive the predicate.
+    static bool compile(const Column &column, const string &operation, const string &value,
+                        ColumnPredicate &out, string &error)
+    {
+        CompareOp op;
+        if (!parseCompareOp(operation, op))
+        {
+            error = "Unknown operator '" + operation + "'.";
+            return false;
+        }
+
+        DataType type = column.getType();
+        if (op == CompareOp::CONTAINS && type != DataType::STRING && type != DataType::CATEGORY)
+        {
+            error = "Operator 'contains' only applies to text columns.";
+            return false;
+        }
+
+        switch (type)
+        {
+        case DataType::INTEGER:
+        case DataType::FLOAT:
+        {
+            double operand = 0.0;
+            if (parseNumber(string_view(value), operand) != ParseStatus::OK)
+            {
+                error = "'" + value + "' is not a valid number.";
+                return false;
+            }
+            out.kernel = type == DataType::INTEGER ? compileOrdered(column, column.getInts(), op, operand)
+                                                   : compileOrdered(column, column.getFloats(), op, operand);
+            break;
+        }
+        case DataType::DATE:
+        {
+            int32_t days = 0;
+            if (parseDateDays(value, days) != ParseStatus::OK)
+            {
+                error = "'" + value + "' is not a valid date (expected YYYY-MM-DD or DD/MM/YYYY).";
+                return false;
+            }
+            out.kernel = compileOrdered(column, column.getDates(), op, days);
+            break;
+        }
+        case DataType::CATEGORY:
+            out.kernel = compileCategory(column, op, value);
+            break;
+        case DataType::STRING:
+            out.kernel = compileString(column, op, value);
+            break;
+        }
+        return true;
+    }
+
+    bool isValid() const { return static_cast<bool>(kernel); }
+
+    // One bit per row of the column, set where the condition holds. With
+    // 'within', rows in all-zero words of that mask are not tested (left 0).
+    // With 'scheduler', the scan runs in parallel word ranges.
+    void evaluate(RowBits &bits, const RowBits *within = nullptr, TaskScheduler *scheduler = nullptr) const
+    {
+        kernel(bits, within, scheduler);
+    }
+
+    // The matching rows, in ascending order
+    RowSelection select(TaskScheduler *scheduler = nullptr) const
+    {
+        RowBits bits;
+        evaluate(bits, nullptr, scheduler);
+        return RowSelection::fromBits(bits);
+    }
+};
+
+// Boolean combination of conditions, e.g.
+//   Distancia_KM > 200 AND (Tipo_Vehiculo = Camioneta OR Peso_Carga_KG >= 800)
+// AND binds tighter than OR; keywords are case-insensitive ("&&"/"||" also work).
+// Values with spaces or special characters can be quoted with ' or ", and
+// unquoted words up to the next AND/OR/parenthesis are joined with one space.
+// Every condition becomes a row bitmask; masks are combined a word at a time.
+class FilterExpression
+{
+private:
+    struct Node
+    {
+        enum Kind
+        {
+            CONDITION,
+            AND,
+            OR
+        } kind = CONDITION;
+        ColumnPredicate predicate;
+        vector<Node> children;
+    };
+
+    struct Token
+    {
+        enum Kind
+        {
+            WORD,
+            OPERATOR,
+            OPEN,
+            CLOSE,
+            END
+        } kind = END;
+        string text;
+        bool quoted = false;
+    };
+
+    Node root;
+    size_t rowCount = 0;
+
+    static bool isOperatorChar(char c) { return c == '=' || c == '!' || c == '<' || c == '>'; }
+
+    static string upper(string text)
+    {
+        for (char &c : text)
+            c = static_cast<char>(toupper(static_cast<unsigned char>(c)));
+        return text;
+    }
+
+    static bool tokenize(const string &text, vector<Token> &tokens, string &error)
+    {
+        size_t i = 0;
+        while (i < text.size())
+        {
+            char c = text[i];
+            if (isspace(static_cast<unsigned char>(c)))
+            {
+                ++i;
+            }
+            else if (c == '(' || c == ')')
+            {
+                tokens.push_back({c == '(' ? Token::OPEN : Token::CLOSE, string(1, c), false});
+                ++i;
+            }
+            else if (c == '"' || c == '\'')
+            {
+                size_t close = text.find(c, i + 1);
+                if (close == string::npos)
+                {
+                    error = "Missing closing quote.";
+                    return false;
+                }
+                tokens.push_back({Token::WORD, text.substr(i + 1, close - i - 1), true});
+                i = close + 1;
+            }
+            else if (isOperatorChar(c))
+            {
+                size_t length = (i + 1 < text.size() && text[i + 1] == '=') ? 2 : 1;
+                tokens.push_back({Token::OPERATOR, text.substr(i, length), false});
+                i += length;
+            }
+            else
+            {
+                size_t start = i;
+                while (i < text.size() && !isspace(static_cast<unsigned char>(text[i])) &&
+                       text[i] != '(' && text[i] != ')' && text[i] != '"' && text[i] != '\'' &&
+                       !isOperatorChar(text[i]))
+                    ++i;
+                tokens.push_back({Token::WORD, text.substr(start, i - start), false});
+            }
+        }
+        tokens.push_back({Token::END, "", false});
+        return true;
+    }
+
+    // Recursive descent over the token list
+    class Parser
+    {
+    private:
+        const ColumnTable &table;
+        const vector<Token> &tokens;
+        size_t pos = 0;
+        string &error;
+
+        const Token &peek() const { return tokens[pos]; }
+
+        bool isKeyword(const Token &token, const char *word, const char *symbol) const
+        {
+            return token.kind == Token::WORD && !token.quoted &&
+                   (upper(token.text) == word || token.text == symbol);
+        }
+
+        bool parseCondition(Node &node)
+        {
+            const Token &columnToken = peek();
+            if (columnToken.kind != Token::WORD)
+            {
+                error = "Expected a column name" + (columnToken.kind == Token::END ? string(" at the end.") : " before '" + columnToken.text + "'.");
+                return false;
+            }
+            string columnName = columnToken.text;
+            ++pos;
+
+            string operation;
+            if (peek().kind == Token::OPERATOR)
+                operation = peek().text;
+            else if (peek().kind == Token::WORD && !peek().quoted && upper(peek().text) == "CONTAINS")
+                operation = "contains";
+            else
+            {
+                error = "Expected an operator after '" + columnName + "'.";
+                return false;
+            }
+            ++pos;
+
+            // The value runs until AND/OR, a parenthesis or the end
+            string value;
+            bool any = false;
+            while (peek().kind == Token::WORD && !isKeyword(peek(), "AND", "&&") && !isKeyword(peek(), "OR", "||"))
+            {
+                if (any)
+                    value += ' ';
+                value += peek().text;
+                any = true;
+                ++pos;
+            }
+            if (!any)
+            {
+                error = "Expected a value after '" + columnName + " " + operation + "'.";
+                return false;
+            }
+
+            size_t columnIndex = table.getSchema()->indexOf(columnName);
+            if (columnIndex == Schema::npos)
+            {
+                error = "Column '" + columnName + "' not found.";
+                return false;
+            }
+
+            node.kind = Node::CONDITION;
+            string conditionError;
+            if (!ColumnPredicate::compile(table.getColumn(columnIndex), operation, value, node.predicate, conditionError))
+            {
+                error = columnName + " " + operation + " " + value + ": " + conditionError;
+                return false;
+            }
+            return true;
+        }
+
+        bool parsePrimary(Node &node)
+        {
+            if (peek().kind != Token::OPEN)
+                return parseCondition(node);
+
+            ++pos;
+            if (!parseOr(node))
+                return false;
+            if (peek().kind != Token::CLOSE)
+            {
+                error = "Missing ')'.";
+                return false;
+            }
+            ++pos;
+            return true;
+        }
+
+        // Parse 'sub (keyword sub)*' into a node of the given kind
+        template <typename Sub>
+        bool parseList(Node &node, Node::Kind kind, const char *word, const char *symbol, Sub sub)
+        {
+            Node first;
+            if (!(this->*sub)(first))
+                return false;
+            if (!isKeyword(peek(), word, symbol))
+            {
+                node = std::move(first);
+                return true;
+            }
+
+            node.kind = kind;
+            node.children.push_back(std::move(first));
+            while (isKeyword(peek(), word, symbol))
+            {
+                ++pos;
+                Node next;
+                if (!(this->*sub)(next))
+                    return false;
+                node.children.push_back(std::move(next));
+            }
+            return true;
+        }
+
+        bool parseAnd(Node &node) { return parseList(node, Node::AND, "AND", "&&", &Parser::parsePrimary); }
+
+    public:
+        Parser(const ColumnTable &t, const vector<Token> &tk, string &e) : table(t), tokens(tk), error(e) {}
+
+        bool parseOr(Node &node) { return parseList(node, Node::OR, "OR", "||", &Parser::parseAnd); }
+
+        bool atEnd() const { return peek().kind == Token::END; }
+        const Token &current() const { return peek(); }
+    };
+
+    bool allZero(const RowBits &bits) const
+    {
+        for (uint64_t word : bits)
+        {
+            if (word)
+                return false;
+        }
+        return true;
+    }
+
+    bool allOnes(const RowBits &bits) const
+    {
+        size_t fullWords = rowCount / 64;
+        for (size_t w = 0; w < fullWords; ++w)
+        {
+            if (~bits[w])
+                return false;
+        }
+        size_t tail = rowCount % 64;
+        return tail == 0 || bits[fullWords] == (uint64_t(1) << tail) - 1;
+    }
+
+    // AND: later conditions only test words that still have a match, and
+    // evaluation stops once nothing is left. OR stops once every row matches.
+    void evaluate(const Node &node, RowBits &bits, TaskScheduler *scheduler) const
+    {
+        if (node.kind == Node::CONDITION)
+        {
+            node.predicate.evaluate(bits, nullptr, scheduler);
+            return;
+        }
+
+        evaluate(node.children[0], bits, scheduler);
+        RowBits other;
+        for (size_t c = 1; c < node.children.size(); ++c)
+        {
+            if (node.kind == Node::AND ? allZero(bits) : allOnes(bits))
+                return;
+
+            const Node &child = node.children[c];
+            if (node.kind == Node::AND && child.kind == Node::CONDITION)
+                child.predicate.evaluate(other, &bits, scheduler);
+            else
+                evaluate(child, other, scheduler);
+
+            if (node.kind == Node::AND)
+            {
+                for (size_t w = 0; w < bits.size(); ++w)
+                    bits[w] &= other[w];
+            }
+            else
+            {
+                for (size_t w = 0; w < bits.size(); ++w)
+                    bits[w] |= other[w];
+            }
+        }
+    }
+
+public:
+    FilterExpression() = default;
+
+    // Parse 'text' and compile every condition against 'table'. Returns false
+    // (and sets 'error') on a syntax error, an unknown column or a bad value.
+    // 'table' must outlive the expression.
+    static bool parse(const ColumnTable &table, const string &text, FilterExpression &out, string &error)
+    {
+        vector<Token> tokens;
+        if (!tokenize(text, tokens, error))
+            return false;
+
+        Parser parser(table, tokens, error);
+        Node root;
+        if (!parser.parseOr(root))
+            return false;
+        if (!parser.atEnd())
+        {
+            error = "Unexpected '" + parser.current().text + "'.";
+            return false;
+        }
+
+        out.root = std::move(root);
+        out.rowCount = table.size();
+        return true;
+    }
+
+    // One bit per row, set where the whole expression holds. With 'scheduler',
+    // every condition is scanned in parallel word ranges.
+    void evaluate(RowBits &bits, TaskScheduler *scheduler = nullptr) const { evaluate(root, bits, scheduler); }
+
+    RowSelection select(TaskScheduler *scheduler = nullptr) const
+    {
+        RowBits bits;
+        evaluate(bits, scheduler);
+        return RowSelection::fromBits(bits);
+    }
+
+    // Number of matching rows, without materializing them
+    size_t count(TaskScheduler *scheduler = nullptr) const
+    {
+        RowBits bits;
+        evaluate(bits, scheduler);
+        return countRowBits(bits);
+    }
+};
+
+#endif // FILTRO_H
@@ -25,16 +25,9 @@ public:
 
     
 
-    void loadCSVFile()
+    // Strip surrounding quotes and, for a bare file name, prefer the CSV/ folder
+    string resolveCSVPath(string filename)
     {
-        cout << "\n+-------------------------------------+" << endl;
-        cout << "|           LOAD CSV FILE             |" << endl;
-        cout << "+-------------------------------------+" << endl;
-
-        cout << "\nEnter CSV filename (or full path): ";
-        string filename;
-        getline(cin, filename);
-
         // Remove quotes if present
         if (filename.front() == '"' && filename.back() == '"')
         {
@@ -60,6 +53,21 @@ public:
             // Ignore filesystem errors and use the raw filename
         }
 
+        return filename;
+    }
+
+    void loadCSVFile()
+    {
+        cout << "\n+-------------------------------------+" << endl;
+        cout << "|           LOAD CSV FILE             |" << endl;
+        cout << "+-------------------------------------+" << endl;
+
+        cout << "\nEnter CSV filename (or full path): ";
+        string filename;
+        getline(cin, filename);
+
+        filename = resolveCSVPath(filename);
+
         cout << "\nAttempting to load: " << filename << endl;
 
         // Call loadCSV with a progress callback that draws a small ASCII progress bar
@@ -215,6 +223,7 @@ public:
 
         cout << "1. Search for specific values" << endl;
         cout << "2. Filter data" << endl;
+        cout << "3. Advanced filter (AND / OR)" << endl;
         cout << "0. Back to main menu" << endl;
         cout << "\nSelect option: ";
 
@@ -229,6 +238,9 @@ public:
         case 2:
             filterData();
             break;
+        case 3:
+            advancedFilter();
+            break;
         case 0:
             return;
         default:
@@ -316,6 +328,12 @@ public:
             case 7:
                 handleExportOption();
                 break;
+            case 8:
+                handleFollowOption();
+                break;
+            case 9:
+                handleStreamOption();
+                break;
             case 0:
                 cout << "\n Thank you for using the Adaptive CSV Analysis System!" << endl;
                 cout << " Your data insights await your next visit!" << endl;
@@ -427,14 +445,13 @@ private:
         getline(cin, columnName);
 
         // Check if column exists
-        auto it = find(columnNames.begin(), columnNames.end(), columnName);
-        if (it == columnNames.end())
+        size_t index = analyzer.getSchema()->indexOf(columnName);
+        if (index == Schema::npos)
         {
             cout << "Error: Column '" << columnName << "' not found!" << endl;
             return;
         }
 
-        size_t index = distance(columnNames.begin(), it);
         DataType type = columnTypes[index]; // Get type directly
 
         cout << "\nAnalysis for column: " << columnName << endl;
@@ -445,68 +462,55 @@ private:
         if (type == DataType::INTEGER || type == DataType::FLOAT)
         {
             // --- NUMERIC ANALYSIS ---
-            vector<double> values;
-            const auto& data = analyzer.getData();
-
-            for (const auto &row : data)
-            {
-                // Directly get the value. Dato.h handles the variant access.
-                values.push_back(row.getNumericValue(index));
-            }
+            // Cached per column: computed once per load, shared with the reports
+            const ColumnStats &stats = analyzer.getColumnStats(index);
+            const NumericSummary &summary = stats.summary;
 
-            if (!values.empty())
+            if (!summary.empty())
             {
-                sort(values.begin(), values.end());
-                double sum = accumulate(values.begin(), values.end(), 0.0);
-                double mean = sum / values.size();
-
                 cout << " Numeric Analysis:" << endl;
-                cout << "   Count: " << values.size() << endl;
-                cout << "   Mean: " << fixed << setprecision(2) << mean << endl;
-                cout << "   Min: " << values.front() << endl;
-                cout << "   Max: " << values.back() << endl;
+                cout << "   Count: " << summary.count << endl;
+                cout << "   Mean: " << fixed << setprecision(2) << summary.mean << endl;
+                cout << "   Min: " << summary.min << endl;
+                cout << "   Max: " << summary.max << endl;
 
-                if (values.size() > 1)
+                if (summary.count > 1)
                 {
-                    double median;
-                    if (values.size() % 2 == 0)
-                        median = (values[values.size() / 2 - 1] + values[values.size() / 2]) / 2.0;
-                    else
-                        median = values[values.size() / 2];
-                    cout << "   Median: " << median << endl;
+                    cout << "   Median: " << stats.quarters.median << endl;
+                    cout << "   P90: " << stats.p90 << endl;
+                    cout << "   P99: " << stats.p99 << endl;
                 }
             }
         }
         else
         {
             // --- CATEGORICAL / STRING / DATE ANALYSIS ---
-            map<string, int> frequency;
-            const auto& data = analyzer.getData();
+            // Counted on typed values in parallel; only the top 5 become strings
+            auto frequency = analyzer.getFrequencies(index, 5);
 
-            for (const auto &row : data)
+            cout << " Categorical Analysis:" << endl;
+            if (frequency.approximate)
             {
-                string value = row.getValueAsString(index);
-                if (!value.empty()) {
-                    frequency[value]++;
-                }
+                // High-cardinality text: estimates from the column's sketches
+                cout << "   Unique values: ~" << frequency.distinct << " (+/-" << fixed << setprecision(1)
+                     << frequency.distinctError * 100.0 << "%)" << endl;
+            }
+            else
+            {
+                cout << "   Unique values: " << frequency.distinct << endl;
             }
-
-            cout << " Categorical Analysis:" << endl;
-            cout << "   Unique values: " << frequency.size() << endl;
             cout << "   Most common values:" << endl;
 
-            vector<pair<string, int>> sortedFreq(frequency.begin(), frequency.end());
-            sort(sortedFreq.begin(), sortedFreq.end(),
-                 [](const auto &a, const auto &b)
-                 { return a.second > b.second; });
-
-            int showCount = min(5, (int)sortedFreq.size());
-            for (int i = 0; i < showCount; ++i)
+            for (size_t i = 0; i < frequency.top.size(); ++i)
             {
-                double percentage = (double)sortedFreq[i].second / analyzer.getRowCount() * 100.0;
-                cout << "      " << sortedFreq[i].first << ": "
-                     << sortedFreq[i].second << " (" << fixed << setprecision(1)
-                     << percentage << "%)" << endl;
+                const auto &entry = frequency.top[i];
+                double percentage = (double)entry.second / analyzer.getRowCount() * 100.0;
+                cout << "      " << entry.first << ": "
+                     << entry.second << " (" << fixed << setprecision(1)
+                     << percentage << "%)";
+                if (frequency.approximate)
+                    cout << " [" << frequency.bounds[i] << "-" << entry.second << "]";
+                cout << endl;
             }
         }
         
@@ -604,10 +608,41 @@ private:
         getline(cin, value);
 
         auto filtered = analyzer.filterData(columnName, operation, value);
+        showFilterResults(filtered, columnName + " " + operation + " " + value);
+    }
+
+    void advancedFilter()
+    {
+        cout << " ADVANCED FILTER" << endl;
+        cout << "Available columns: ";
+        const auto &columnNames = analyzer.getColumnNames();
+        const auto &columnTypes = analyzer.getColumnTypes();
+
+        for (size_t i = 0; i < columnNames.size(); ++i)
+        {
+            cout << columnNames[i] << " (" << dataTypeToString(columnTypes[i]) << ")";
+            if (i < columnNames.size() - 1)
+                cout << ", ";
+        }
+        cout << endl;
+
+        cout << "\nCombine conditions with AND / OR and parentheses, e.g." << endl;
+        cout << "  Distancia_KM > 200 AND (Tipo_Vehiculo = Camioneta OR Peso_Carga_KG >= 800)" << endl;
+        cout << "Quote values that contain spaces or symbols: Origen = 'Puerto Vallarta'" << endl;
+        cout << "\nEnter filter: ";
+        string expression;
+        getline(cin, expression);
+
+        auto filtered = analyzer.filterByExpression(expression);
+        showFilterResults(filtered, expression);
+    }
+
+    void showFilterResults(const RowSelection &filtered, const string &criteria)
+    {
+        const auto &columnNames = analyzer.getColumnNames();
 
         cout << "\n Filter Results:" << endl;
-        cout << "Found " << filtered.size() << " rows matching criteria: "
-             << columnName << " " << operation << " " << value << endl;
+        cout << "Found " << filtered.size() << " rows matching criteria: " << criteria << endl;
 
         if (filtered.size() > 0 && filtered.size() <= 10)
         {
@@ -621,8 +656,9 @@ private:
             cout << string(15 * columnNames.size(), '-') << endl;
 
             // Print filtered rows
-            for (const auto &row : filtered)
+            for (size_t rowIndex : filtered)
             {
+                const auto &row = analyzer.getData()[rowIndex];
                 for (size_t i = 0; i < columnNames.size(); ++i)
                 {
                     cout << setw(15) << row.getValueAsString(i);
@@ -632,7 +668,45 @@ private:
         }
         else if (filtered.size() > 10)
         {
-            cout << "Too many results to display. Use 'Export & Display Options' to see more." << endl;
+            cout << "Too many results to display. Use option 4 below to see some of them." << endl;
+        }
+
+        if (!filtered.empty())
+            analyzeSelection(filtered);
+    }
+
+    // Follow-up actions on a filter result. The selection only holds row
+    // numbers, so the reports read the loaded data in place.
+    void analyzeSelection(const RowSelection &selection)
+    {
+        cout << "\nAnalyze the " << selection.size() << " filtered rows?" << endl;
+        cout << "1. Numeric statistics" << endl;
+        cout << "2. Histogram" << endl;
+        cout << "3. Export report" << endl;
+        cout << "4. Display first N rows" << endl;
+        cout << "0. No" << endl;
+        cout << "\nSelect option: ";
+
+        switch (getIntInput())
+        {
+        case 1:
+            analyzer.printNumericStatistics(&selection);
+            break;
+        case 2:
+            handleHistogramOption(&selection);
+            break;
+        case 3:
+            handleExportOption(&selection);
+            break;
+        case 4:
+        {
+            cout << "Enter number of rows to display: ";
+            int rows = getIntInput();
+            analyzer.printSelection(selection, rows > 0 ? rows : 10);
+            break;
+        }
+        default:
+            break;
         }
     }
 
@@ -737,6 +811,8 @@ private:
         // --- NUEVAS OPCIONES ---
         cout << "| 6. Visualizar Histograma (ASCII)    |" << endl;
         cout << "| 7. Exportar Reporte TXT             |" << endl;
+        cout << "| 8. Follow File (new rows)           |" << endl;
+        cout << "| 9. Stream Large File (summary)      |" << endl;
         // -----------------------
         cout << "| 0. Exit                             |" << endl;
         cout << "+-------------------------------------+" << endl;
@@ -753,7 +829,9 @@ private:
     }
 
     // Manejador para la Opción 6
-    void handleHistogramOption()
+    // With a selection (from a filter) only those rows are plotted and the
+    // caller takes care of pausing
+    void handleHistogramOption(const RowSelection *selection = nullptr)
     {
         if (!dataLoaded) {
             cout << "Please load a CSV file first (Option 1)." << endl;
@@ -781,14 +859,85 @@ private:
 
         // Llamamos a la función que creamos en Analisis.h
         // Puedes ajustar los 'bins' (barras) aquí, por defecto 10
-        analyzer.plotHistogram(colName, 15); 
+        analyzer.plotHistogram(colName, 15, selection); 
         
+        if (selection)
+            return;
         cout << "\nPresione Enter para continuar...";
         cin.get();
     }
 
+    // Option 8: pick up rows appended to the loaded file (e.g. a growing log)
+    void handleFollowOption()
+    {
+        // A file that only had its header when loaded can be followed too
+        if (analyzer.getColumnCount() == 0 && !checkDataLoaded())
+            return;
+
+        cout << "\n--- FOLLOW FILE ---" << endl;
+        cout << "Refresh every how many seconds? (0 = once, now): ";
+        int seconds = max(0, getIntInput());
+        int refreshes = 1;
+        if (seconds > 0)
+        {
+            cout << "How many refreshes?: ";
+            refreshes = max(1, getIntInput());
+        }
+
+        int done = 0;
+        analyzer.followCSV(std::chrono::seconds(seconds), [&](size_t added)
+                           {
+            cout << " +" << added << " rows (" << analyzer.getRowCount() << " total)" << endl;
+            return ++done < refreshes; });
+        if (analyzer.getRowCount() > 0)
+            dataLoaded = true;
+        pauseForUser();
+    }
+
+    // Option 9: summarize a file too large to load, in one pass without keeping rows
+    void handleStreamOption()
+    {
+        cout << "\n+-------------------------------------+" << endl;
+        cout << "|        STREAM LARGE FILE            |" << endl;
+        cout << "+-------------------------------------+" << endl;
+
+        cout << "\nEnter CSV filename (or full path): ";
+        string filename;
+        getline(cin, filename);
+        if (filename.empty())
+            return;
+        filename = resolveCSVPath(filename);
+
+        cout << "Count rows matching a filter (e.g. Distancia_KM > 200 AND Origen = Guadalajara)," << endl;
+        cout << "or leave empty: ";
+        string filter;
+        getline(cin, filter);
+
+        StreamReport report;
+        bool ok = analyzer.streamCSV(filename, report, filter, [&](int percent)
+                                     {
+            const int width = 40;
+            int filled = (percent * width) / 100;
+            std::cout << "\r[" << std::string(filled, '#') << std::string(width - filled, ' ') << "] ";
+            std::cout << std::setw(3) << percent << "%" << std::flush;
+            if (percent == 100) std::cout << std::endl; });
+        if (!ok)
+        {
+            pauseForUser();
+            return;
+        }
+        analyzer.printStreamReport(report);
+
+        cout << "Histogram of a numeric column (name, or empty to skip): ";
+        string columnName;
+        getline(cin, columnName);
+        if (!columnName.empty())
+            analyzer.plotStreamHistogram(report, columnName, 15);
+        pauseForUser();
+    }
+
     // Manejador para la Opción 7
-    void handleExportOption()
+    void handleExportOption(const RowSelection *selection = nullptr)
     {
         if (!dataLoaded) {
             cout << "Please load a CSV file first (Option 1)." << endl;
@@ -822,7 +971,7 @@ private:
 
         // Attempt to export; on failure report error but do not silently write outside Reports/
         try {
-            analyzer.exportReportTXT(outPath.string());
+            analyzer.exportReportTXT(outPath.string(), selection);
             cout << "\nReporte guardado en: " << outPath.string() << endl;
         } catch (const std::exception &e) {
             cout << "\nError al generar el reporte: " << e.what() << endl;
@@ -830,6 +979,8 @@ private:
             cout << "\nError desconocido al generar el reporte." << endl;
         }
         
+        if (selection)
+            return;
         cout << "\nPresione Enter para continuar...";
         cin.get();
     }
@@ -0,0 +1 @@
+#include "LectorCSV.h"
\ No newline at end of file
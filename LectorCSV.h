@@ -0,0 +1,672 @@
+#ifndef LECTORCSV_H
+#define LECTORCSV_H
+
+#include <string>
+#include <string_view>
+#include <vector>
+#include <cstring>
+#include <cstdint>
+#include <bit>
+#include <algorithm>
+
+#ifdef _WIN32
+#ifndef NOMINMAX
+#define NOMINMAX
+#endif
+#ifndef WIN32_LEAN_AND_MEAN
+#define WIN32_LEAN_AND_MEAN
+#endif
+#include <windows.h>
+#else
+#include <fcntl.h>
+#include <sys/mman.h>
+#include <sys/stat.h>
+#include <unistd.h>
+#endif
+
+using namespace std;
+
+// Read-only memory mapping of a whole file. Cells tokenized from view() point
+// straight into the mapping, so it has to outlive them.
+class MappedFile
+{
+private:
+    const char *ptr = nullptr;
+    size_t length = 0;
+    bool opened = false;
+#ifdef _WIN32
+    HANDLE fileHandle = INVALID_HANDLE_VALUE;
+    HANDLE mappingHandle = nullptr;
+#endif
+
+public:
+    MappedFile() = default;
+    explicit MappedFile(const string &path) { open(path); }
+    ~MappedFile() { close(); }
+
+    MappedFile(const MappedFile &) = delete;
+    MappedFile &operator=(const MappedFile &) = delete;
+
+    bool open(const string &path)
+    {
+        close();
+#ifdef _WIN32
+        fileHandle = CreateFileA(path.c_str(), GENERIC_READ, FILE_SHARE_READ | FILE_SHARE_WRITE,
+                                 nullptr, OPEN_EXISTING, FILE_FLAG_SEQUENTIAL_SCAN, nullptr);
+        if (fileHandle == INVALID_HANDLE_VALUE)
+            return false;
+
+        LARGE_INTEGER fileSize;
+        if (!GetFileSizeEx(fileHandle, &fileSize))
+        {
+            close();
+            return false;
+        }
+        length = static_cast<size_t>(fileSize.QuadPart);
+
+        // Mapping a zero-length file is an error on Windows, but an empty view is fine
+        if (length > 0)
+        {
+            mappingHandle = CreateFileMappingA(fileHandle, nullptr, PAGE_READONLY, 0, 0, nullptr);
+            if (mappingHandle == nullptr)
+            {
+                close();
+                return false;
+            }
+            ptr = static_cast<const char *>(MapViewOfFile(mappingHandle, FILE_MAP_READ, 0, 0, 0));
+            if (ptr == nullptr)
+            {
+                close();
+                return false;
+            }
+        }
+#else
+        int fd = ::open(path.c_str(), O_RDONLY);
+        if (fd < 0)
+            return false;
+
+        struct stat st;
+        if (fstat(fd, &st) != 0)
+        {
+            ::close(fd);
+            return false;
+        }
+        length = static_cast<size_t>(st.st_size);
+
+        if (length > 0)
+        {
+            void *mapped = mmap(nullptr, length, PROT_READ, MAP_PRIVATE, fd, 0);
+            if (mapped == MAP_FAILED)
+            {
+                ::close(fd);
+                length = 0;
+                return false;
+            }
+            madvise(mapped, length, MADV_SEQUENTIAL);
+            ptr = static_cast<const char *>(mapped);
+        }
+        // The mapping stays valid after the descriptor is closed
+        ::close(fd);
+#endif
+        opened = true;
+        return true;
+    }
+
+    void close()
+    {
+#ifdef _WIN32
+        if (ptr != nullptr)
+            UnmapViewOfFile(ptr);
+        if (mappingHandle != nullptr)
+            CloseHandle(mappingHandle);
+        if (fileHandle != INVALID_HANDLE_VALUE)
+            CloseHandle(fileHandle);
+        mappingHandle = nullptr;
+        fileHandle = INVALID_HANDLE_VALUE;
+#else
+        if (ptr != nullptr)
+            munmap(const_cast<char *>(ptr), length);
+#endif
+        ptr = nullptr;
+        length = 0;
+        opened = false;
+    }
+
+    // Drop the cached pages of [offset, offset + bytes) once they have been
+    // read, so a one-pass scan of a huge file keeps a bounded resident size.
+    // The range stays readable (it is paged in again if touched).
+    void discard(size_t offset, size_t bytes)
+    {
+#ifndef _WIN32
+        size_t page = static_cast<size_t>(sysconf(_SC_PAGESIZE));
+        size_t begin = offset / page * page;
+        size_t end = min(length, offset + bytes) / page * page;
+        if (ptr != nullptr && end > begin)
+            madvise(const_cast<char *>(ptr) + begin, end - begin, MADV_DONTNEED);
+#else
+        (void)offset;
+        (void)bytes;
+#endif
+    }
+
+    bool isOpen() const { return opened; }
+    const char *data() const { return ptr; }
+    size_t size() const { return length; }
+    string_view view() const { return ptr ? string_view(ptr, length) : string_view(); }
+};
+
+// Byte range of one record inside the mapped file
+struct RecordSpan
+{
+    uint64_t offset;
+    uint64_t length;
+};
+
+inline bool isCellWhitespace(char c)
+{
+    return c == ' ' || c == '\t' || c == '\r' || c == '\n';
+}
+
+inline string_view trimCell(string_view cell)
+{
+    const char *first = cell.data();
+    const char *last = first + cell.size();
+    while (first != last && isCellWhitespace(*first))
+        ++first;
+    while (last != first && isCellWhitespace(last[-1]))
+        --last;
+    return string_view(first, static_cast<size_t>(last - first));
+}
+
+// =========================================================
+// Structural classification kernels
+// =========================================================
+// Each kernel classifies one 64-byte block and returns one bit per byte for
+// quotes, delimiters and newlines. The tokenizer turns those masks into the
+// positions of the separators that sit outside quoted fields.
+
+struct BlockMasks
+{
+    uint64_t quotes;
+    uint64_t delimiters;
+    uint64_t newlines;
+};
+
+enum class TokenizerKernel
+{
+    SCALAR,
+    SSE2,
+    AVX2
+};
+
+inline BlockMasks classifyBlockScalar(const char *block, char delimiter)
+{
+    BlockMasks masks{0, 0, 0};
+    for (int i = 0; i < 64; ++i)
+    {
+        char c = block[i];
+        masks.quotes |= static_cast<uint64_t>(c == '"') << i;
+        masks.delimiters |= static_cast<uint64_t>(c == delimiter) << i;
+        masks.newlines |= static_cast<uint64_t>(c == '\n') << i;
+    }
+    return masks;
+}
+
+#if defined(__x86_64__) || defined(_M_X64)
+#define LECTORCSV_X86 1
+#include <immintrin.h>
+
+inline BlockMasks classifyBlockSSE2(const char *block, char delimiter)
+{
+    const __m128i quote = _mm_set1_epi8('"');
+    const __m128i delim = _mm_set1_epi8(delimiter);
+    const __m128i newline = _mm_set1_epi8('\n');
+
+    BlockMasks masks{0, 0, 0};
+    for (int i = 0; i < 4; ++i)
+    {
+        __m128i bytes = _mm_loadu_si128(reinterpret_cast<const __m128i *>(block + 16 * i));
+        masks.quotes |= static_cast<uint64_t>(static_cast<uint16_t>(_mm_movemask_epi8(_mm_cmpeq_epi8(bytes, quote)))) << (16 * i);
+        masks.delimiters |= static_cast<uint64_t>(static_cast<uint16_t>(_mm_movemask_epi8(_mm_cmpeq_epi8(bytes, delim)))) << (16 * i);
+        masks.newlines |= static_cast<uint64_t>(static_cast<uint16_t>(_mm_movemask_epi8(_mm_cmpeq_epi8(bytes, newline)))) << (16 * i);
+    }
+    return masks;
+}
+
+#if defined(__GNUC__) || defined(__clang__)
+#define LECTORCSV_AVX2 1
+
+__attribute__((target("avx2"))) inline BlockMasks classifyBlockAVX2(const char *block, char delimiter)
+{
+    const __m256i quote = _mm256_set1_epi8('"');
+    const __m256i delim = _mm256_set1_epi8(delimiter);
+    const __m256i newline = _mm256_set1_epi8('\n');
+
+    BlockMasks masks{0, 0, 0};
+    for (int i = 0; i < 2; ++i)
+    {
+        __m256i bytes = _mm256_loadu_si256(reinterpret_cast<const __m256i *>(block + 32 * i));
+        masks.quotes |= static_cast<uint64_t>(static_cast<uint32_t>(_mm256_movemask_epi8(_mm256_cmpeq_epi8(bytes, quote)))) << (32 * i);
+        masks.delimiters |= static_cast<uint64_t>(static_cast<uint32_t>(_mm256_movemask_epi8(_mm256_cmpeq_epi8(bytes, delim)))) << (32 * i);
+        masks.newlines |= static_cast<uint64_t>(static_cast<uint32_t>(_mm256_movemask_epi8(_mm256_cmpeq_epi8(bytes, newline)))) << (32 * i);
+    }
+    return masks;
+}
+#endif
+#endif
+
+inline bool isTokenizerKernelSupported(TokenizerKernel kernel)
+{
+    switch (kernel)
+    {
+    case TokenizerKernel::SCALAR:
+        return true;
+    case TokenizerKernel::SSE2:
+#ifdef LECTORCSV_X86
+        return true;
+#else
+        return false;
+#endif
+    case TokenizerKernel::AVX2:
+#ifdef LECTORCSV_AVX2
+        return __builtin_cpu_supports("avx2");
+#else
+        return false;
+#endif
+    }
+    return false;
+}
+
+// Kernel in use; picks the widest supported one the first time it is called
+inline TokenizerKernel &activeTokenizerKernel()
+{
+    static TokenizerKernel kernel = isTokenizerKernelSupported(TokenizerKernel::AVX2)   ? TokenizerKernel::AVX2
+                                    : isTokenizerKernelSupported(TokenizerKernel::SSE2) ? TokenizerKernel::SSE2
+                                                                                        : TokenizerKernel::SCALAR;
+    return kernel;
+}
+
+// Force a specific kernel (e.g. SCALAR for testing); unsupported kernels are ignored
+inline bool setTokenizerKernel(TokenizerKernel kernel)
+{
+    if (!isTokenizerKernelSupported(kernel))
+        return false;
+    activeTokenizerKernel() = kernel;
+    return true;
+}
+
+inline const char *tokenizerKernelName(TokenizerKernel kernel)
+{
+    switch (kernel)
+    {
+    case TokenizerKernel::SCALAR:
+        return "scalar";
+    case TokenizerKernel::SSE2:
+        return "SSE2";
+    case TokenizerKernel::AVX2:
+        return "AVX2";
+    }
+    return "unknown";
+}
+
+using ClassifyBlockFn = BlockMasks (*)(const char *, char);
+
+inline ClassifyBlockFn classifyBlockFunction(TokenizerKernel kernel)
+{
+    switch (kernel)
+    {
+#ifdef LECTORCSV_AVX2
+    case TokenizerKernel::AVX2:
+        return classifyBlockAVX2;
+#endif
+#ifdef LECTORCSV_X86
+    case TokenizerKernel::SSE2:
+        return classifyBlockSSE2;
+#endif
+    default:
+        return classifyBlockScalar;
+    }
+}
+
+// Bit i of the result is the XOR of bits 0..i of x (quote parity up to each byte)
+inline uint64_t prefixXor(uint64_t x)
+{
+    x ^= x << 1;
+    x ^= x << 2;
+    x ^= x << 4;
+    x ^= x << 8;
+    x ^= x << 16;
+    x ^= x << 32;
+    return x;
+}
+
+// Quote state of a left-to-right scan over 64-byte blocks, carried from one
+// block to the next. A quote only opens a quoted field at the start of a field
+// (leading blanks allowed) or right after a closing quote (a doubled ""
+// inside the field). Anywhere else, e.g. 12" pipe, it is plain text, so one
+// stray quote cannot turn the rest of the file into a single quoted cell.
+class QuoteScanner
+{
+private:
+    char delimiter;
+    ClassifyBlockFn classifyBlock;
+    bool inside = false;       // the last byte scanned is inside a quoted field
+    bool fieldStart = true;    // only blanks since the last separator
+    bool afterClosing = false; // the last byte scanned closed a quoted field
+    size_t strayQuotes = 0;
+
+    static bool isBlank(char c) { return c == ' ' || c == '\t' || c == '\r'; }
+
+    // Byte by byte, for the blocks where quote parity alone is not enough
+    uint64_t scanSlow(const char *bytes, size_t available)
+    {
+        uint64_t separators = 0;
+        for (size_t i = 0; i < available; ++i)
+        {
+            char c = bytes[i];
+            if (inside)
+            {
+                if (c == '"')
+                {
+                    inside = false;
+                    afterClosing = true;
+                }
+                continue;
+            }
+
+            if (c == '"')
+            {
+                if (fieldStart || afterClosing)
+                    inside = true;
+                else
+                    strayQuotes++;
+                fieldStart = false;
+            }
+            else if (c == delimiter || c == '\n')
+            {
+                separators |= uint64_t(1) << i;
+                fieldStart = true;
+            }
+            else if (!isBlank(c))
+            {
+                fieldStart = false;
+            }
+            afterClosing = false;
+        }
+        return separators;
+    }
+
+public:
+    explicit QuoteScanner(char delim)
+        : delimiter(delim), classifyBlock(classifyBlockFunction(activeTokenizerKernel())) {}
+
+    // Bits of the delimiters and newlines outside quoted fields among the
+    // first 'available' (at most 64) bytes at 'bytes'
+    uint64_t scan(const char *bytes, size_t available)
+    {
+        char padded[64];
+        if (available < 64)
+        {
+            // The padding is masked out below: any byte may be the delimiter
+            memset(padded, ' ', sizeof(padded));
+            memcpy(padded, bytes, available);
+            bytes = padded;
+        }
+        uint64_t valid = available < 64 ? (uint64_t(1) << available) - 1 : ~uint64_t(0);
+
+        BlockMasks masks = classifyBlock(bytes, delimiter);
+        uint64_t structural = (masks.delimiters | masks.newlines) & valid;
+
+        // Parity of all quotes is exact unless a quote that would open a
+        // quoted stretch neither starts a field nor follows a closing quote.
+        // Quotes after leading blanks also take the slow path.
+        uint64_t quoted = prefixXor(masks.quotes) ^ (inside ? ~uint64_t(0) : 0);
+        uint64_t opening = masks.quotes & quoted;
+        uint64_t allowed = (structural << 1) | (masks.quotes << 1) | uint64_t(fieldStart || afterClosing);
+        if ((opening & ~allowed) != 0)
+            return scanSlow(bytes, available);
+
+        uint64_t separators = structural & ~quoted;
+        size_t last = available - 1;
+        inside = (quoted >> last) & 1;
+        afterClosing = !inside && ((masks.quotes >> last) & 1);
+        if (inside || afterClosing)
+        {
+            fieldStart = false;
+        }
+        else
+        {
+            // Blanks after the last separator keep a field start; an all
+            // blank block keeps the previous state
+            for (size_t i = available; i-- > 0;)
+            {
+                if ((separators >> i) & 1)
+                {
+                    fieldStart = true;
+                    break;
+                }
+                if (!isBlank(bytes[i]))
+                {
+                    fieldStart = false;
+                    break;
+                }
+            }
+        }
+        return separators;
+    }
+
+    // Quotes read as plain text so far
+    size_t getStrayQuoteCount() const { return strayQuotes; }
+};
+
+// =========================================================
+// RFC 4180 tokenizer
+// =========================================================
+// Reads records one by one. Quoted fields may contain delimiters, newlines and
+// doubled quotes (""); a quote elsewhere in an unquoted field is kept as text.
+// Unquoted cells are trimmed like before; quoted cells keep their content
+// verbatim. Cells are views into the text, except quoted cells
+// with doubled quotes, which are unescaped into a scratch buffer that stays
+// valid until the next call to next().
+class CSVTokenizer
+{
+private:
+    static constexpr size_t windowBytes = 64 * 1024;
+
+    string_view text;
+    size_t recordStart;
+    size_t indexedEnd;
+    QuoteScanner quotes;
+    vector<size_t> structurals;
+    size_t nextStructural = 0;
+    vector<size_t> fieldEnds;
+    string scratch;
+    const vector<char> *wantedFields = nullptr;
+
+public:
+    // 'start' must be the beginning of a record
+    CSVTokenizer(string_view csvText, char delim, size_t start = 0)
+        : text(csvText), recordStart(start), indexedEnd(start), quotes(delim) {}
+
+    // Offset of the next record that next() will return
+    size_t position() const { return recordStart; }
+
+    // Quotes inside unquoted fields, read as plain text (see QuoteScanner)
+    size_t getStrayQuoteCount() const { return quotes.getStrayQuoteCount(); }
+
+    // Only cut the fields flagged in 'wanted' (one flag per column); the others
+    // come back as empty views, their bytes never trimmed or unescaped.
+    // nullptr cuts every field. 'wanted' must outlive the tokenizer.
+    void setWantedFields(const vector<char> *wanted) { wantedFields = wanted; }
+
+    // Read the next record into 'cells'. Blank lines produce no cells.
+    bool next(vector<string_view> &cells, RecordSpan *span = nullptr)
+    {
+        cells.clear();
+        if (recordStart >= text.size())
+            return false;
+
+        // 1. Collect the separators of this record from the structural index
+        fieldEnds.clear();
+        size_t recordEnd = text.size();
+        while (true)
+        {
+            if (nextStructural == structurals.size())
+            {
+                if (!indexMore())
+                {
+                    fieldEnds.push_back(text.size());
+                    break;
+                }
+                continue;
+            }
+            size_t position = structurals[nextStructural++];
+            fieldEnds.push_back(position);
+            if (text[position] == '\n')
+            {
+                recordEnd = position;
+                break;
+            }
+        }
+
+        size_t begin = recordStart;
+        if (span)
+            *span = RecordSpan{begin, recordEnd - begin};
+        recordStart = recordEnd < text.size() ? recordEnd + 1 : text.size();
+
+        // Only a record without separators can be a blank line
+        if (fieldEnds.size() == 1 && trimCell(text.substr(begin, recordEnd - begin)).empty())
+            return true;
+
+        // 2. Cut the cells; unescaped cells never outgrow the record, so the
+        // scratch buffer does not reallocate while views into it are handed out
+        scratch.clear();
+        scratch.reserve(recordEnd - begin);
+        for (size_t end : fieldEnds)
+        {
+            size_t field = cells.size();
+            bool wanted = !wantedFields || (field < wantedFields->size() && (*wantedFields)[field]);
+            cells.push_back(wanted ? extractCell(begin, end) : string_view());
+            begin = end + 1;
+        }
+        return true;
+    }
+
+private:
+    // Classify the next window of the text and append the positions of its
+    // delimiters and newlines that are outside quoted fields
+    bool indexMore()
+    {
+        if (indexedEnd >= text.size())
+            return false;
+
+        structurals.erase(structurals.begin(), structurals.begin() + nextStructural);
+        nextStructural = 0;
+
+        size_t windowEnd = min(text.size(), indexedEnd + windowBytes);
+        for (size_t block = indexedEnd; block < windowEnd; block += 64)
+        {
+            uint64_t separators = quotes.scan(text.data() + block, min<size_t>(64, windowEnd - block));
+            while (separators != 0)
+            {
+                structurals.push_back(block + static_cast<size_t>(countr_zero(separators)));
+                separators &= separators - 1;
+            }
+        }
+
+        indexedEnd = windowEnd;
+        return true;
+    }
+
+    string_view extractCell(size_t begin, size_t end)
+    {
+        string_view cell = trimCell(string_view(text.data() + begin, end - begin));
+        if (cell.empty() || cell.front() != '"')
+            return cell;
+
+        // Quoted field: drop the surrounding quotes (a missing closing quote is tolerated)
+        size_t closing = (cell.size() >= 2 && cell.back() == '"') ? cell.size() - 1 : cell.size();
+        string_view inner = cell.substr(1, closing - 1);
+        if (inner.find('"') == string_view::npos)
+            return inner;
+
+        size_t start = scratch.size();
+        for (size_t i = 0; i < inner.size(); ++i)
+        {
+            scratch.push_back(inner[i]);
+            if (inner[i] == '"' && i + 1 < inner.size() && inner[i + 1] == '"')
+                ++i;
+        }
+        return string_view(scratch.data() + start, scratch.size() - start);
+    }
+};
+
+// First record boundary at or after 'target' (the end of the text if none),
+// with quotes tracked like CSVTokenizer from 'from', which must start a record
+inline size_t recordBoundaryAfter(string_view text, size_t from, size_t target, char delimiter)
+{
+    if (target >= text.size())
+        return text.size();
+
+    QuoteScanner quotes(delimiter);
+    for (size_t block = from; block < text.size(); block += 64)
+    {
+        uint64_t separators = quotes.scan(text.data() + block, min<size_t>(64, text.size() - block));
+        if (block + 64 <= target)
+            continue;
+        for (; separators != 0; separators &= separators - 1)
+        {
+            size_t position = block + static_cast<size_t>(countr_zero(separators));
+            if (position >= target && text[position] == '\n')
+                return position + 1;
+        }
+    }
+    return text.size();
+}
+
+// Split text[from, end) into about 'parts' ranges that each start at a record
+// boundary. Quotes are tracked so newlines inside quoted fields are skipped.
+inline vector<size_t> splitRecordAligned(string_view text, size_t from, size_t parts, char delimiter)
+{
+    vector<size_t> boundaries{from};
+    size_t total = text.size() - from;
+
+    for (size_t i = 1; i < parts; ++i)
+    {
+        size_t target = max(boundaries.back(), from + total * i / parts);
+        if (target >= text.size())
+            break;
+
+        // Each scan starts at the previous boundary, so the text is read once
+        size_t boundary = recordBoundaryAfter(text, boundaries.back(), target, delimiter);
+        if (boundary >= text.size())
+            break;
+        if (boundary > boundaries.back())
+            boundaries.push_back(boundary);
+    }
+
+    boundaries.push_back(text.size());
+    return boundaries;
+}
+
+// Offset just past the last newline of text[from, end) that is outside quotes,
+// i.e. the end of the last complete record; 'from' if there is none. Used to
+// leave a record that is still being written for later.
+inline size_t completeRecordsEnd(string_view text, size_t from, char delimiter)
+{
+    size_t end = from;
+    QuoteScanner quotes(delimiter);
+    for (size_t block = from; block < text.size(); block += 64)
+    {
+        uint64_t separators = quotes.scan(text.data() + block, min<size_t>(64, text.size() - block));
+        for (; separators != 0; separators &= separators - 1)
+        {
+            size_t position = block + static_cast<size_t>(countr_zero(separators));
+            if (text[position] == '\n')
+                end = position + 1;
+        }
+    }
+    return end;
+}
+
+#endif // LECTORCSV_H
@@ -0,0 +1 @@
+#include "Planificador.h"
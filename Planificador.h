@@ -0,0 +1,326 @@
+#ifndef PLANIFICADOR_H
+#define PLANIFICADOR_H
+
+#include <algorithm>
+#include <atomic>
+#include <chrono>
+#include <condition_variable>
+#include <deque>
+#include <exception>
+#include <functional>
+#include <memory>
+#include <mutex>
+#include <thread>
+#include <vector>
+
+using namespace std;
+
+// Flag shared with the tasks of one parallel call: once set, ranges that have
+// not started are skipped (a running one may poll isCancelled() to stop early)
+class CancellationToken
+{
+private:
+    atomic<bool> cancelled{false};
+
+public:
+    void cancel() { cancelled = true; }
+    void reset() { cancelled = false; }
+    bool isCancelled() const { return cancelled.load(memory_order_relaxed); }
+};
+
+// Work-stealing pool shared by loading, statistics, filtering and exports.
+// Every parallel call submits one range of indices; a worker splits the range
+// in halves, keeps the first and queues the rest, so idle workers steal the
+// largest pieces left (oldest first) while the owner works newest first.
+//
+// Exactly getWorkerCount() threads run tasks: a thread outside the pool that
+// starts a parallel call sleeps until it is done, and a worker that starts a
+// nested one runs the queued tasks of that call while it waits, so nesting
+// never adds threads. The waiting worker takes no tasks of other calls: it
+// may be inside a lock or a once_flag (e.g. a column loader) that one of
+// them needs, and each call can always be finished by its own caller.
+class TaskScheduler
+{
+private:
+    // Shared by the ranges of one parallel call; lives on the caller's stack
+    struct TaskGroup
+    {
+        function<void(size_t, size_t)> body;
+        size_t grain = 1;
+        const CancellationToken *cancel = nullptr;
+        atomic<size_t> remaining{0}; // indices not finished (or skipped) yet
+        atomic<bool> skipped{false};
+        std::mutex errorLock;
+        exception_ptr error;
+    };
+
+    struct Task
+    {
+        TaskGroup *group = nullptr;
+        size_t begin = 0;
+        size_t end = 0;
+    };
+
+    struct TaskQueue
+    {
+        std::mutex lock;
+        deque<Task> tasks;
+    };
+
+    // queues[i] belongs to worker i; the last one takes the calls made from
+    // threads outside the pool
+    vector<unique_ptr<TaskQueue>> queues;
+    vector<std::thread> threads;
+    atomic<size_t> queued{0};
+    std::mutex sleepLock;
+    condition_variable activity; // a task was queued or a call finished
+    bool stopping = false;
+
+    struct WorkerIdentity
+    {
+        const TaskScheduler *scheduler = nullptr;
+        size_t index = 0;
+    };
+
+    static WorkerIdentity &currentWorker()
+    {
+        static thread_local WorkerIdentity identity;
+        return identity;
+    }
+
+    // Queue of the calling thread (the shared one outside the pool)
+    size_t callerQueue() const
+    {
+        const WorkerIdentity &identity = currentWorker();
+        return identity.scheduler == this ? identity.index : threads.size();
+    }
+
+    void notifyActivity()
+    {
+        {
+            lock_guard<std::mutex> guard(sleepLock);
+        }
+        activity.notify_all();
+    }
+
+    void push(size_t queue, const Task &task)
+    {
+        {
+            lock_guard<std::mutex> guard(queues[queue]->lock);
+            queues[queue]->tasks.push_back(task);
+        }
+        queued++;
+        notifyActivity();
+    }
+
+    // Newest task of our own queue, else the oldest of any other. With
+    // 'only', just the tasks of that group are considered.
+    bool take(size_t self, Task &task, const TaskGroup *only = nullptr)
+    {
+        if (queued.load() == 0)
+            return false;
+        for (size_t step = 0; step < queues.size(); ++step)
+        {
+            size_t victim = (self + step) % queues.size();
+            lock_guard<std::mutex> guard(queues[victim]->lock);
+            deque<Task> &tasks = queues[victim]->tasks;
+            bool newest = step == 0 && self < threads.size();
+            auto matches = [only](const Task &candidate)
+            { return !only || candidate.group == only; };
+
+            if (newest)
+            {
+                auto it = find_if(tasks.rbegin(), tasks.rend(), matches);
+                if (it == tasks.rend())
+                    continue;
+                task = *it;
+                tasks.erase(next(it).base());
+            }
+            else
+            {
+                auto it = find_if(tasks.begin(), tasks.end(), matches);
+                if (it == tasks.end())
+                    continue;
+                task = *it;
+                tasks.erase(it);
+            }
+            queued--;
+            return true;
+        }
+        return false;
+    }
+
+    void execute(Task task, size_t self)
+    {
+        TaskGroup &group = *task.group;
+        while (task.end - task.begin > group.grain)
+        {
+            size_t middle = task.begin + (task.end - task.begin) / 2;
+            push(self, Task{&group, middle, task.end});
+            task.end = middle;
+        }
+
+        if (group.skipped || (group.cancel && group.cancel->isCancelled()))
+        {
+            group.skipped = true;
+        }
+        else
+        {
+            try
+            {
+                group.body(task.begin, task.end);
+            }
+            catch (...)
+            {
+                lock_guard<std::mutex> guard(group.errorLock);
+                if (!group.error)
+                    group.error = current_exception();
+                group.skipped = true; // the rest of the call is abandoned
+            }
+        }
+
+        // The caller may return as soon as this reaches zero: 'group' is not
+        // touched afterwards
+        size_t done = task.end - task.begin;
+        if (group.remaining.fetch_sub(done) == done)
+            notifyActivity();
+    }
+
+    void workerLoop(size_t index)
+    {
+        currentWorker() = WorkerIdentity{this, index};
+        while (true)
+        {
+            Task task;
+            if (take(index, task))
+            {
+                execute(task, index);
+                continue;
+            }
+            unique_lock<std::mutex> guard(sleepLock);
+            activity.wait(guard, [&]
+                          { return stopping || queued.load() > 0; });
+            if (stopping && queued.load() == 0)
+                return;
+        }
+    }
+
+    void start(unsigned workers)
+    {
+        if (workers == 0)
+            workers = max(1u, std::thread::hardware_concurrency());
+        stopping = false;
+        queues.clear();
+        for (unsigned i = 0; i <= workers; ++i)
+            queues.push_back(make_unique<TaskQueue>());
+        for (unsigned i = 0; i < workers; ++i)
+            threads.emplace_back(&TaskScheduler::workerLoop, this, static_cast<size_t>(i));
+    }
+
+    void stop()
+    {
+        {
+            lock_guard<std::mutex> guard(sleepLock);
+            stopping = true;
+        }
+        activity.notify_all();
+        for (auto &thread : threads)
+            thread.join();
+        threads.clear();
+    }
+
+public:
+    // 'workers' threads, 0 = one per hardware thread
+    explicit TaskScheduler(unsigned workers = 0) { start(workers); }
+    ~TaskScheduler() { stop(); }
+
+    TaskScheduler(const TaskScheduler &) = delete;
+    TaskScheduler &operator=(const TaskScheduler &) = delete;
+
+    // Restart the pool with 'workers' threads (0 = automatic). Not to be
+    // called while a parallel call is running.
+    void setWorkerCount(unsigned workers)
+    {
+        stop();
+        start(workers);
+    }
+
+    unsigned getWorkerCount() const { return static_cast<unsigned>(threads.size()); }
+
+    // Run 'body(begin, end)' over [0, count) in ranges of at most 'grain'
+    // indices and return once all of them are done. 'onWait', if given, is
+    // called about every 10 ms by a caller outside the pool while it waits
+    // (e.g. to report progress). The first exception thrown by 'body' cancels
+    // the ranges not started and is rethrown here. Returns false if some
+    // ranges were skipped because of 'cancel'.
+    template <typename Body>
+    bool parallelRange(size_t count, size_t grain, Body &&body,
+                       const CancellationToken *cancel = nullptr,
+                       const function<void()> &onWait = nullptr)
+    {
+        if (count == 0)
+            return true;
+
+        TaskGroup group;
+        group.body = [&body](size_t begin, size_t end)
+        { body(begin, end); };
+        group.grain = max<size_t>(grain, 1);
+        group.cancel = cancel;
+        group.remaining = count;
+
+        size_t self = callerQueue();
+        push(self, Task{&group, 0, count});
+
+        if (self < threads.size())
+        {
+            // A worker waiting on a nested call keeps running its tasks meanwhile
+            while (group.remaining.load() > 0)
+            {
+                Task task;
+                if (take(self, task, &group))
+                {
+                    execute(task, self);
+                    continue;
+                }
+                // Tasks of other calls may stay queued, so wake on any
+                // activity (or after 1 ms) and look again
+                unique_lock<std::mutex> guard(sleepLock);
+                if (group.remaining.load() > 0)
+                    activity.wait_for(guard, std::chrono::milliseconds(1));
+            }
+        }
+        else
+        {
+            unique_lock<std::mutex> guard(sleepLock);
+            while (group.remaining.load() > 0)
+            {
+                if (onWait)
+                {
+                    guard.unlock();
+                    onWait();
+                    guard.lock();
+                }
+                activity.wait_for(guard, std::chrono::milliseconds(10), [&]
+                                  { return group.remaining.load() == 0; });
+            }
+        }
+
+        if (group.error)
+            rethrow_exception(group.error);
+        return !group.skipped;
+    }
+
+    // One task per index: 'body(i)' for every i in [0, count)
+    template <typename Body>
+    bool parallelFor(size_t count, Body &&body, const CancellationToken *cancel = nullptr,
+                     const function<void()> &onWait = nullptr)
+    {
+        return parallelRange(count, 1, [&body](size_t begin, size_t end)
+                             {
+                                 for (size_t i = begin; i < end; ++i)
+                                     body(i); },
+                             cancel, onWait);
+    }
+};
+
+#endif // PLANIFICADOR_H
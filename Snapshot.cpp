@@ -0,0 +1 @@
+#include "Snapshot.h"
@@ -0,0 +1,231 @@
+#ifndef SNAPSHOT_H
+#define SNAPSHOT_H
+
+#include "Columna.h"
+#include "Estadisticas.h"
+#include "LectorCSV.h"
+#include <filesystem>
+#include <fstream>
+#include <stdexcept>
+
+using namespace std;
+
+// Binary columnar snapshot of a loaded CSV, so later sessions skip tokenizing,
+// type inference and conversion. Layout (native byte order):
+//   header   magic "CSVSNAP\0", format version, byte-order tag
+//   source   path, size, modification time and delimiter of the CSV
+//   schema   row count, column names and types
+//   stats    per column: cached ColumnStats (if computed) and quantile sketch
+//   index    offset and length of every column block
+//   columns  one Column::write image per column
+// Opening reads everything but the column blocks; those are read from the
+// mapping the first time each column is used.
+
+inline constexpr char snapshotMagic[8] = {'C', 'S', 'V', 'S', 'N', 'A', 'P', '\0'};
+inline constexpr uint32_t snapshotVersion = 2;
+inline constexpr uint32_t snapshotByteOrder = 0x01020304;
+
+// Identity of the CSV a snapshot was made from: a snapshot is only reused
+// while the file still has the same path, size and modification time
+struct SnapshotKey
+{
+    string path; // absolute
+    uint64_t size = 0;
+    int64_t modified = 0; // file clock ticks
+    char delimiter = ',';
+
+    bool operator==(const SnapshotKey &other) const = default;
+
+    // Key of the file at 'csvPath' as it is now; false if it cannot be read
+    static bool of(const string &csvPath, char delimiter, SnapshotKey &key)
+    {
+        std::error_code error;
+        filesystem::path absolute = filesystem::absolute(csvPath, error);
+        if (error)
+            return false;
+        key.size = filesystem::file_size(absolute, error);
+        if (error)
+            return false;
+        auto modified = filesystem::last_write_time(absolute, error);
+        if (error)
+            return false;
+        key.path = absolute.lexically_normal().string();
+        key.modified = static_cast<int64_t>(modified.time_since_epoch().count());
+        key.delimiter = delimiter;
+        return true;
+    }
+};
+
+// File holding the snapshot of 'key' inside 'directory': the CSV's name plus a
+// hash of its full path, so equally named files in other folders don't collide
+inline string snapshotPathFor(const string &directory, const SnapshotKey &key)
+{
+    uint64_t hash = 0xcbf29ce484222325ULL; // FNV-1a
+    for (char c : key.path)
+    {
+        hash ^= static_cast<unsigned char>(c);
+        hash *= 0x100000001b3ULL;
+    }
+    char suffix[24];
+    snprintf(suffix, sizeof(suffix), "-%016llx.snap", static_cast<unsigned long long>(hash));
+    return (filesystem::path(directory) / (filesystem::path(key.path).stem().string() + suffix)).string();
+}
+
+// What a snapshot restores. Stats entries with rows == 0 were not cached.
+struct SnapshotContents
+{
+    SnapshotKey key;
+    ColumnTable table;
+    vector<ColumnStats> stats;
+    vector<QuantileSketch> sketches;
+};
+
+// Write 'table' (plus its stats and sketches, one entry per column or none)
+// to 'file'. The snapshot is written next to it and renamed into place, so a
+// reader never sees half a file.
+inline bool writeSnapshot(const string &file, const SnapshotKey &key, const ColumnTable &table,
+                          const vector<ColumnStats> &stats, const vector<QuantileSketch> &sketches,
+                          string &error)
+{
+    std::error_code fsError;
+    filesystem::path target(file);
+    if (target.has_parent_path())
+        filesystem::create_directories(target.parent_path(), fsError);
+
+    string temporary = file + ".tmp";
+    {
+        ofstream out(temporary, ios::binary | ios::trunc);
+        if (!out)
+        {
+            error = "Cannot create " + temporary;
+            return false;
+        }
+
+        writeRaw(out, snapshotMagic, sizeof(snapshotMagic));
+        writeValue(out, snapshotVersion);
+        writeValue(out, snapshotByteOrder);
+        writeString(out, key.path);
+        writeValue(out, key.size);
+        writeValue(out, key.modified);
+        writeValue(out, key.delimiter);
+
+        size_t columnCount = table.getColumnCount();
+        writeValue(out, static_cast<uint64_t>(table.size()));
+        writeValue(out, static_cast<uint64_t>(columnCount));
+        for (size_t i = 0; i < columnCount; ++i)
+        {
+            writeString(out, table.getColumnNames()[i]);
+            writeValue(out, static_cast<uint8_t>(table.getColumnTypes()[i]));
+        }
+
+        for (size_t i = 0; i < columnCount; ++i)
+        {
+            bool hasStats = i < stats.size() && stats[i].rows == table.size();
+            writeValue(out, static_cast<uint8_t>(hasStats));
+            if (hasStats)
+                writeColumnStats(out, stats[i]);
+            bool hasSketch = i < sketches.size() && !sketches[i].empty();
+            writeValue(out, static_cast<uint8_t>(hasSketch));
+            if (hasSketch)
+                sketches[i].write(out);
+        }
+
+        // Column index, filled in once the blocks are written
+        streampos indexPosition = out.tellp();
+        vector<uint64_t> blocks(2 * columnCount, 0);
+        writeRaw(out, blocks.data(), blocks.size() * sizeof(uint64_t));
+        for (size_t i = 0; i < columnCount; ++i)
+        {
+            blocks[2 * i] = static_cast<uint64_t>(out.tellp());
+            table.getColumn(i).write(out);
+            blocks[2 * i + 1] = static_cast<uint64_t>(out.tellp()) - blocks[2 * i];
+        }
+        out.seekp(indexPosition);
+        writeRaw(out, blocks.data(), blocks.size() * sizeof(uint64_t));
+
+        if (!out.flush())
+        {
+            error = "Cannot write " + temporary;
+            return false;
+        }
+    }
+
+    filesystem::rename(temporary, target, fsError);
+    if (fsError)
+    {
+        filesystem::remove(temporary, fsError);
+        error = "Cannot replace " + file;
+        return false;
+    }
+    return true;
+}
+
+// Open the snapshot in 'file'. With 'expected', it is only accepted for that
+// exact source file. The columns stay in the mapped file until first use.
+inline bool openSnapshot(const string &file, const SnapshotKey *expected, SnapshotContents &out)
+{
+    auto mapping = make_shared<MappedFile>();
+    if (!mapping->open(file))
+        return false;
+
+    BinaryReader in(mapping->view());
+    if (in.take(sizeof(snapshotMagic)) != string_view(snapshotMagic, sizeof(snapshotMagic)) ||
+        in.value<uint32_t>() != snapshotVersion || in.value<uint32_t>() != snapshotByteOrder)
+        return false;
+
+    out.key.path = in.text();
+    out.key.size = in.value<uint64_t>();
+    out.key.modified = in.value<int64_t>();
+    out.key.delimiter = in.value<char>();
+    if (!in.ok() || (expected && !(out.key == *expected)))
+        return false;
+
+    uint64_t rows = in.value<uint64_t>();
+    uint64_t columnCount = in.value<uint64_t>();
+    if (!in.ok() || columnCount > mapping->size())
+        return false;
+
+    vector<string> names(columnCount);
+    vector<DataType> types(columnCount);
+    for (size_t i = 0; i < columnCount; ++i)
+    {
+        names[i] = in.text();
+        uint8_t type = in.value<uint8_t>();
+        if (type > static_cast<uint8_t>(DataType::CATEGORY))
+            return false;
+        types[i] = static_cast<DataType>(type);
+    }
+
+    out.stats.assign(columnCount, ColumnStats());
+    out.sketches.assign(columnCount, QuantileSketch());
+    for (size_t i = 0; i < columnCount; ++i)
+    {
+        if (in.value<uint8_t>() && !readColumnStats(in, out.stats[i]))
+            return false;
+        if (in.value<uint8_t>() && !out.sketches[i].read(in))
+            return false;
+    }
+
+    vector<uint64_t> blocks(2 * columnCount);
+    for (auto &value : blocks)
+        value = in.value<uint64_t>();
+    if (!in.ok())
+        return false;
+    for (size_t i = 0; i < columnCount; ++i)
+    {
+        if (blocks[2 * i] > mapping->size() || blocks[2 * i + 1] > mapping->size() - blocks[2 * i])
+            return false;
+    }
+
+    // Each column block is read once, when the column is first used
+    out.table.setLazyColumns(Schema::create(names, types), rows,
+                             [mapping, blocks, rows](size_t i, Column &column)
+                             {
+                                 BinaryReader block(mapping->view().substr(blocks[2 * i], blocks[2 * i + 1]));
+                                 if (!column.read(block) || column.size() != rows)
+                                     throw runtime_error("Damaged column block in snapshot");
+                             });
+    return true;
+}
+
+#endif // SNAPSHOT_H
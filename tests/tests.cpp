@@ -0,0 +1,470 @@
+// Behaviour checks for the loader, the column storage and the statistics.
+// Build and run from the repository root:
+//   g++ -std=c++20 -O2 -pthread -I. tests/tests.cpp -o tests.exe && ./tests.exe
+// Exits with 1 if any check fails.
+
+#include "Analisis.h"
+#include <chrono>
+#include <filesystem>
+#include <fstream>
+#include <iostream>
+#include <map>
+#include <sstream>
+#include <thread>
+
+using namespace std;
+
+static int failures = 0;
+
+#define CHECK(condition)                                                            \
+    do                                                                              \
+    {                                                                               \
+        if (!(condition))                                                           \
+        {                                                                           \
+            failures++;                                                             \
+            cerr << __FILE__ << ":" << __LINE__ << ": failed: " #condition << endl; \
+        }                                                                           \
+    } while (false)
+
+// Write 'contents' to a file in the temporary directory and return its path
+static string temporaryFile(const string &name, const string &contents)
+{
+    filesystem::path path = filesystem::temp_directory_path() / name;
+    ofstream out(path, ios::binary | ios::trunc);
+    out << contents;
+    return path.string();
+}
+
+static void appendToFile(const string &path, const string &contents)
+{
+    ofstream out(path, ios::binary | ios::app);
+    out << contents;
+}
+
+static string cell(const CSVAnalyzer &analyzer, size_t row, size_t column)
+{
+    return analyzer.getData()[row].getValueAsString(column);
+}
+
+// INTEGER cells keep all 64 bits, in the columns and in the Dato rows built
+// from them
+static void testWideIntegers()
+{
+    string path = temporaryFile("csv_tests_wide.csv", "id,big\n1,5000000000\n2,-9000000000000000000\n3,7\n");
+    CSVAnalyzer analyzer;
+    analyzer.setSnapshotCache("");
+    CHECK(analyzer.loadCSV(path));
+    CHECK(analyzer.getColumnTypes()[1] == DataType::INTEGER);
+    if (analyzer.getRowCount() != 3)
+    {
+        CHECK(analyzer.getRowCount() == 3);
+        return;
+    }
+
+    DataValue value = analyzer.getData()[0].getValue(1);
+    CHECK(holds_alternative<int64_t>(value) && get<int64_t>(value) == 5000000000LL);
+    CHECK(analyzer.getData()[1].toDato().getValueAsString(1) == "-9000000000000000000");
+    CHECK(analyzer.getData()[0].getNumericValue(1) == 5e9);
+}
+
+// Any byte may be the delimiter, a space included, and the last record may
+// have no line break
+static void testSpaceDelimiter()
+{
+    string path = temporaryFile("csv_tests_space.csv", "a b c\n1 2 x\n3 4 y\n5 6 zz");
+    CSVAnalyzer analyzer(' ');
+    analyzer.setSnapshotCache("");
+    CHECK(analyzer.loadCSV(path));
+    CHECK(analyzer.getRowCount() == 3);
+    CHECK(analyzer.getRowCount() == 3 && cell(analyzer, 2, 2) == "zz");
+}
+
+// A quote inside an unquoted field is text; it must not open a quoted field
+// that swallows the following rows
+static void testStrayQuotes()
+{
+    string path = temporaryFile("csv_tests_stray.csv",
+                                "id,item,size\n1,12\" pipe,5\n2,bolt,6\n3,\"nut, hex\",7\n4,3/4\" cap,8\n");
+    CSVAnalyzer analyzer;
+    analyzer.setSnapshotCache("");
+    CHECK(analyzer.loadCSV(path));
+    CHECK(analyzer.getRowCount() == 4);
+    if (analyzer.getRowCount() != 4)
+        return;
+    CHECK(cell(analyzer, 0, 1) == "12\" pipe");
+    CHECK(cell(analyzer, 1, 1) == "bolt");
+    CHECK(cell(analyzer, 2, 1) == "nut, hex");
+    CHECK(cell(analyzer, 3, 1) == "3/4\" cap");
+    CHECK(cell(analyzer, 3, 2) == "8");
+}
+
+// Quoted fields with doubled quotes, delimiters and line breaks. The file is
+// longer than the head sample, so type inference also samples strata windows
+// (each with its own tokenizer) after reading unescaped cells.
+static void testQuotedInference()
+{
+    string text = "id,name,note\n";
+    for (int i = 0; i < 3000; ++i)
+    {
+        text += to_string(i) + ",\"Name \"\"" + to_string(i % 7) + "\"\"\",\"one, " + to_string(i % 3) +
+                "\nline \"\"two\"\"\"\n";
+    }
+    string path = temporaryFile("csv_tests_quoted.csv", text);
+
+    CSVAnalyzer analyzer;
+    analyzer.setSnapshotCache("");
+    CSVAnalyzer::InferenceSampling sampling;
+    sampling.headRows = 50;
+    sampling.strata = 8;
+    sampling.rowsPerStratum = 20;
+    analyzer.setInferenceSampling(sampling);
+
+    CHECK(analyzer.loadCSV(path));
+    CHECK(analyzer.getRowCount() == 3000);
+    CHECK(analyzer.getColumnCount() == 3);
+    if (analyzer.getRowCount() != 3000 || analyzer.getColumnCount() != 3)
+        return;
+    CHECK(analyzer.getColumnTypes()[0] == DataType::INTEGER);
+    CHECK(analyzer.getColumnTypes()[1] == DataType::CATEGORY);
+    CHECK(cell(analyzer, 0, 1) == "Name \"0\"");
+    CHECK(cell(analyzer, 2999, 1) == "Name \"" + to_string(2999 % 7) + "\"");
+    CHECK(cell(analyzer, 4, 2) == "one, 1\nline \"two\"");
+}
+
+// Dato rows parse INTEGER cells with the same 64-bit range as the columns
+static void testDatoIntegerRange()
+{
+    Dato row({"n"}, {DataType::INTEGER});
+    CHECK(row.setValueFromString(0, "5000000000") == ParseStatus::OK);
+    CHECK(row.getValueAsString(0) == "5000000000");
+    CHECK(row.setValueFromString(0, "-9223372036854775808") == ParseStatus::OK);
+    CHECK(row.setValueFromString(0, "9223372036854775808") == ParseStatus::OUT_OF_RANGE);
+    CHECK(row.isNull(0));
+}
+
+// Appending to an interning arena shares the values it already holds, and
+// the distinctness probe runs even when the cells arrive through append
+static void testStringArenaAppend()
+{
+    StringArena repeated;
+    repeated.setInterning(true);
+    repeated.push_back("north");
+    repeated.push_back("south");
+
+    StringArena chunk;
+    chunk.setInterning(true);
+    for (int i = 0; i < 100; ++i)
+        chunk.push_back(i % 2 == 0 ? "north" : "south");
+    repeated.append(std::move(chunk));
+    CHECK(repeated.size() == 102);
+    CHECK(chunk.size() == 0);
+    CHECK(repeated[101] == "south");
+    CHECK(repeated[100].data() == repeated[0].data());
+    CHECK(repeated[101].data() == repeated[1].data());
+
+    StringArena distinct;
+    distinct.setInterning(true);
+    StringArena many;
+    for (int i = 0; i < 10000; ++i)
+        many.push_back("value" + to_string(i));
+    distinct.append(std::move(many));
+    CHECK(!distinct.isInterning());
+    CHECK(distinct.size() == 10000);
+    CHECK(distinct[0] == "value0" && distinct[4096] == "value4096" && distinct[9999] == "value9999");
+}
+
+// Follow mode picks up rows appended to a file that only had its header
+static void testFollowHeaderOnly()
+{
+    string path = temporaryFile("csv_tests_follow_empty.csv", "id,city\n");
+    CSVAnalyzer analyzer;
+    analyzer.setSnapshotCache("");
+    CHECK(!analyzer.loadCSV(path));
+    CHECK(analyzer.getColumnCount() == 2);
+
+    appendToFile(path, "1,Leon\n2,Colima\n3,Leon\n4,Tepic");
+    CHECK(analyzer.appendNewRows() == 3); // the last line is not complete yet
+    CHECK(analyzer.getColumnTypes()[0] == DataType::INTEGER);
+    appendToFile(path, "\n");
+    CHECK(analyzer.appendNewRows() == 1);
+    CHECK(analyzer.getRowCount() == 4 && cell(analyzer, 3, 1) == "Tepic");
+}
+
+// Following a projected load fills the projected columns only; the others
+// read every row, old and new, when they are first used
+static void testFollowProjected()
+{
+    string path = temporaryFile("csv_tests_follow_projected.csv", "id,amount,city\n1,10,Leon\n2,20,Colima\n");
+    CSVAnalyzer analyzer;
+    analyzer.setSnapshotCache("");
+    analyzer.setColumnProjection({"amount"});
+    CHECK(analyzer.loadCSV(path));
+    double mean = analyzer.getColumnStats(1).summary.mean;
+    CHECK(mean == 15.0);
+
+    appendToFile(path, "3,30,Tepic\n4,40,Leon\n");
+    CHECK(analyzer.appendNewRows() == 2);
+    CHECK(analyzer.getData().isColumnLoaded(1));
+    CHECK(!analyzer.getData().isColumnLoaded(0));
+    CHECK(!analyzer.getData().isColumnLoaded(2));
+    CHECK(analyzer.getColumnStats(1).summary.mean == 25.0);
+    appendToFile(path, "5,50,Colima\n");
+    CHECK(analyzer.appendNewRows() == 1);
+
+    CHECK(analyzer.getData().getColumn(2).size() == 5);
+    CHECK(cell(analyzer, 2, 2) == "Tepic");
+    CHECK(cell(analyzer, 4, 2) == "Colima");
+    CHECK(analyzer.getColumnStats(0).summary.mean == 3.0);
+}
+
+static string sampleTable(size_t rows)
+{
+    string text = "id,amount,kind,day,label\n";
+    for (size_t i = 0; i < rows; ++i)
+    {
+        text += to_string(i) + ",";
+        if (i % 11 != 0)
+            text += to_string((i * 37) % 1000) + "." + to_string(i % 10);
+        text += string(",") + (i % 3 == 0 ? "A" : i % 3 == 1 ? "B" : "C");
+        text += ",2024-01-" + to_string(1 + i % 28);
+        text += ",item" + to_string(i % 500) + "\n";
+    }
+    return text;
+}
+
+// A snapshot reopens the same table, statistics and frequencies
+static void testSnapshotRoundTrip()
+{
+    string path = temporaryFile("csv_tests_snapshot.csv", sampleTable(5000));
+    string snapshot = (filesystem::temp_directory_path() / "csv_tests_snapshot.snap").string();
+
+    CSVAnalyzer original;
+    original.setSnapshotCache("");
+    CHECK(original.loadCSV(path));
+    CHECK(original.saveSnapshot(snapshot));
+
+    CSVAnalyzer reopened;
+    reopened.setSnapshotCache("");
+    CHECK(reopened.openSnapshot(snapshot));
+    CHECK(reopened.getRowCount() == original.getRowCount());
+    CHECK(reopened.getColumnNames() == original.getColumnNames());
+    CHECK(reopened.getColumnTypes() == original.getColumnTypes());
+    if (reopened.getRowCount() != original.getRowCount() || reopened.getColumnCount() != original.getColumnCount())
+        return;
+
+    size_t mismatches = 0;
+    for (size_t r = 0; r < original.getRowCount(); ++r)
+    {
+        for (size_t c = 0; c < original.getColumnCount(); ++c)
+            mismatches += cell(original, r, c) != cell(reopened, r, c);
+    }
+    CHECK(mismatches == 0);
+
+    for (size_t c = 0; c < original.getColumnCount(); ++c)
+    {
+        const ColumnStats &before = original.getColumnStats(c);
+        const ColumnStats &after = reopened.getColumnStats(c);
+        CHECK(before.count == after.count);
+        CHECK(before.distinct == after.distinct);
+        CHECK(before.summary.mean == after.summary.mean);
+        CHECK(before.quarters.median == after.quarters.median);
+    }
+    CHECK(original.getFrequencies(4, 5).top == reopened.getFrequencies(4, 5).top);
+    filesystem::remove(snapshot);
+}
+
+// A CATEGORY block whose codes point past its dictionary (or whose dictionary
+// repeats an entry) is rejected instead of read out of bounds
+static void testDamagedCategoryBlock()
+{
+    auto image = [](const vector<uint8_t> &codes, const vector<string> &dictionary)
+    {
+        ostringstream out;
+        writeValue(out, static_cast<uint8_t>(DataType::CATEGORY));
+        writeValue(out, uint64_t(0)); // nulls
+        writeValue(out, uint64_t(0)); // parse failures
+        writeVector(out, vector<uint8_t>());
+        writeValue(out, uint8_t(1)); // code width
+        writeVector(out, codes);
+        writeValue(out, static_cast<uint64_t>(dictionary.size()));
+        for (const string &value : dictionary)
+            writeString(out, value);
+        return out.str();
+    };
+
+    string valid = image({0, 1, 0}, {"a", "b"});
+    Column column(DataType::CATEGORY);
+    BinaryReader good(valid);
+    CHECK(column.read(good) && column.size() == 3 && column.getAsString(1) == "b");
+
+    string outOfRange = image({0, 2, 0}, {"a", "b"});
+    BinaryReader bad(outOfRange);
+    CHECK(!Column(DataType::CATEGORY).read(bad));
+
+    string repeated = image({0, 1, 2}, {"a", "a", "b"});
+    BinaryReader shifted(repeated);
+    CHECK(!Column(DataType::CATEGORY).read(shifted));
+}
+
+// Empty and unparseable numbers are nulls; ties in frequency tables are
+// ordered by value, and FLOAT values that round alike keep distinct labels
+static void testFrequencies()
+{
+    string path = temporaryFile("csv_tests_frequencies.csv",
+                                "n,t,x\n1,b,1.001\n,a,1.004\nx,c,1.004\n4,a,2.5\n5,b,1.001\n6,c,1.004\n");
+    CSVAnalyzer analyzer;
+    analyzer.setSnapshotCache("");
+    CHECK(analyzer.loadCSV(path));
+    const ColumnStats &stats = analyzer.getColumnStats(0);
+    CHECK(stats.count == 4);
+    CHECK(stats.nulls == 2);
+    CHECK(stats.summary.mean == 4.0);
+
+    auto text = analyzer.getFrequencies(1, 3);
+    vector<pair<string, size_t>> expected = {{"a", 2}, {"b", 2}, {"c", 2}};
+    CHECK(text.top == expected);
+    CHECK(text.distinct == 3);
+
+    auto decimals = analyzer.getFrequencies(2, 5);
+    expected = {{"1.004", 3}, {"1.001", 2}, {"2.5", 1}};
+    CHECK(decimals.top == expected);
+}
+
+// Statistics merged from row ranges match one pass over the whole column
+static void testRangeMerge()
+{
+    string path = temporaryFile("csv_tests_ranges.csv", sampleTable(20000));
+    CSVAnalyzer analyzer;
+    analyzer.setSnapshotCache("");
+    CHECK(analyzer.loadCSV(path));
+
+    for (size_t c = 0; c < analyzer.getColumnCount(); ++c)
+    {
+        const Column &column = analyzer.getData().getColumn(c);
+        ColumnStats serial = computeColumnStats(column);
+
+        ColumnStats merged;
+        for (size_t first = 0; first < column.size(); first += 3000)
+            mergeColumnStats(merged, columnStatsOfRows(column, first, min(first + 3000, column.size())), column);
+        if (!merged.quantilesReady)
+            computeColumnQuantiles(merged, column);
+
+        CHECK(merged.rows == serial.rows);
+        CHECK(merged.count == serial.count);
+        CHECK(merged.nulls == serial.nulls);
+        CHECK(merged.distinct == serial.distinct);
+        CHECK(merged.categoryCounts == serial.categoryCounts);
+        CHECK(merged.summary.count == serial.summary.count);
+        CHECK(merged.summary.min == serial.summary.min);
+        CHECK(merged.summary.max == serial.summary.max);
+        CHECK(fabs(merged.summary.mean - serial.summary.mean) <= 1e-9 * (1.0 + fabs(serial.summary.mean)));
+        CHECK(fabs(merged.summary.stddev() - serial.summary.stddev()) <= 1e-9 * (1.0 + serial.summary.stddev()));
+        CHECK(merged.quarters.median == serial.quarters.median);
+        CHECK(merged.p99 == serial.p99);
+    }
+}
+
+// A worker waiting on a nested call only runs tasks of that call, so a
+// nested call made under a once_flag never re-enters it
+static void testNestedCalls()
+{
+    TaskScheduler scheduler(4);
+    static thread_local bool insideOnce = false;
+    atomic<size_t> reentered{0};
+    for (int round = 0; round < 20; ++round)
+    {
+        once_flag flag;
+        scheduler.parallelFor(32, [&](size_t i)
+                              {
+                                  if (insideOnce)
+                                  {
+                                      reentered++;
+                                      return;
+                                  }
+                                  // Short outer tasks keep the other workers free to steal the nested ones
+                                  if (i % 8 != 0)
+                                  {
+                                      this_thread::sleep_for(chrono::microseconds(75));
+                                      return;
+                                  }
+                                  call_once(flag, [&]
+                                            {
+                                                insideOnce = true;
+                                                scheduler.parallelFor(16, [](size_t)
+                                                                      { this_thread::sleep_for(chrono::microseconds(300)); });
+                                                insideOnce = false; }); });
+    }
+    CHECK(reentered == 0);
+}
+
+// Reports over a projected load read the pending columns in parallel tasks
+static void testProjectedReport()
+{
+    string path = temporaryFile("csv_tests_projected.csv", sampleTable(20000));
+    CSVAnalyzer analyzer;
+    analyzer.setSnapshotCache("");
+    analyzer.setWorkerThreads(4);
+    analyzer.setColumnProjection({});
+    CHECK(analyzer.loadCSV(path));
+    analyzer.prepareColumnStats();
+    CHECK(analyzer.getColumnStats(0).summary.mean == 9999.5);
+    CHECK(analyzer.getColumnStats(2).categoryCounts.size() == 3);
+}
+
+// HyperLogLog stays within three standard errors; heavy hitters bound the
+// true counts
+static void testSketches()
+{
+    for (size_t n : {1000, 100000, 1000000})
+    {
+        HyperLogLog distinct;
+        for (size_t i = 0; i < n; ++i)
+            distinct.addHash(i * 2654435761ULL + 17);
+        double error = fabs(static_cast<double>(distinct.estimate()) - static_cast<double>(n)) / static_cast<double>(n);
+        CHECK(error <= 3 * HyperLogLog::relativeError());
+    }
+
+    FrequencySketch sketch;
+    map<string, size_t> exact;
+    for (size_t i = 0; i < 200000; ++i)
+    {
+        // A few very frequent values and a long tail
+        string value = i % 4 == 0 ? "hot" + to_string(i % 5) : "cold" + to_string(i);
+        sketch.add(value);
+        exact[value]++;
+    }
+    auto top = sketch.top(5);
+    CHECK(top.size() == 5);
+    for (const auto &hitter : top)
+    {
+        CHECK(hitter.value.rfind("hot", 0) == 0);
+        CHECK(hitter.lower <= exact[hitter.value] && exact[hitter.value] <= hitter.count);
+    }
+}
+
+int main()
+{
+    testWideIntegers();
+    testSpaceDelimiter();
+    testStrayQuotes();
+    testQuotedInference();
+    testDatoIntegerRange();
+    testStringArenaAppend();
+    testFollowHeaderOnly();
+    testFollowProjected();
+    testSnapshotRoundTrip();
+    testDamagedCategoryBlock();
+    testFrequencies();
+    testRangeMerge();
+    testNestedCalls();
+    testProjectedReport();
+    testSketches();
+
+    if (failures > 0)
+    {
+        cerr << failures << " check(s) failed" << endl;
+        return 1;
+    }
+    cout << "All checks passed" << endl;
+    return 0;
+}